@@ -0,0 +1,154 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "minisat/core/Solver.h"
+#include "sat/graph_solver.h"
+#include "trace_solver.h"
+
+// Micro-benchmark of ActiveVerticesConnected on square grids, without a full solve:
+//   csugar_bench_avc [-s steps] [-n max_side]
+// The constraint is driven directly through a Minisat::Solver subclass which replays a recorded
+// trace of decisions and backtracks, in the order MiniSat itself would call it.
+
+using namespace Minisat;
+using csugar::TraceSolver;
+
+namespace {
+
+class Random {
+public:
+    Random(uint32_t seed) : state_(seed * 2654435761u + 1) {}
+    int Next(int n) {
+        state_ = state_ * 1103515245u + 12345u;
+        return (state_ >> 16) % n;
+    }
+private:
+    uint32_t state_;
+};
+
+// Each step is either a decision (a literal, toInt(lit) >= 0) or a backtrack to level `-step - 1`.
+// Decisions follow a random walk on the grid with occasional jumps, so that they interact like a real search.
+// The trace does not depend on the propagator: decisions on literals already assigned are skipped on replay.
+std::vector<int> RecordTrace(int side, int n_steps, uint32_t seed) {
+    Random rand(seed);
+    std::vector<int> ret;
+    int level = 0, until_backtrack = 0;
+    int y = rand.Next(side), x = rand.Next(side);
+    while (ret.size() < n_steps) {
+        if (until_backtrack == 0) {
+            level = level == 0 ? 0 : rand.Next(level);
+            ret.push_back(-level - 1);
+            until_backtrack = 5 + rand.Next(40);
+            continue;
+        }
+        if (rand.Next(10) == 0) {
+            y = rand.Next(side);
+            x = rand.Next(side);
+        } else {
+            int d = rand.Next(4);
+            y = std::max(0, std::min(side - 1, y + (d == 0) - (d == 1)));
+            x = std::max(0, std::min(side - 1, x + (d == 2) - (d == 3)));
+        }
+        // vertices are inactive more often than active, as in most connectivity puzzles
+        ret.push_back(toInt(mkLit(y * side + x, rand.Next(3) != 0)));
+        ++level;
+        --until_backtrack;
+    }
+    return ret;
+}
+
+struct GridResult {
+    uint64_t n_propagate, n_reason, n_undo, n_conflicts;
+    double propagate_seconds, reason_seconds, undo_seconds;
+};
+
+GridResult RunGrid(int side, const std::vector<int>& trace) {
+    int n = side * side;
+    std::vector<Lit> lits;
+    TraceSolver solver;
+    for (int i = 0; i < n; ++i) lits.push_back(mkLit(solver.newVar()));
+
+    ActiveVerticesConnected constraint(lits, csugar::GridEdges(side));
+    constraint.setTimed(true);
+    vec<Lit> watchers;
+    if (!constraint.initialize(solver, watchers)) abort();
+
+    double undo_seconds = 0;
+    vec<Lit> reason;
+    int qhead = 0;
+    auto backtrack = [&](int level) {
+        auto start = std::chrono::steady_clock::now();
+        solver.Backtrack(level);
+        undo_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        qhead = std::min(qhead, solver.TrailSize());
+    };
+
+    for (int step : trace) {
+        if (step < 0) {
+            if (solver.Level() > -step - 1) backtrack(-step - 1);
+            continue;
+        }
+        Lit p = toLit(step);
+        if (solver.value(p) != l_Undef) continue;
+
+        solver.Decide(p);
+        bool conflict = false;
+        while (qhead < solver.TrailSize()) {
+            int implied_begin = solver.TrailSize();
+            if (!constraint.propagate(solver, solver.TrailAt(qhead++))) {
+                conflict = true;
+                break;
+            }
+            // explain the implied literals before the constraint sees them, as the solver does
+            for (int i = implied_begin; i < solver.TrailSize(); ++i) {
+                reason.clear();
+                constraint.calcReason(solver, solver.TrailAt(i), reason);
+            }
+        }
+        if (conflict) {
+            reason.clear();
+            constraint.calcReason(solver, lit_Undef, reason);
+            backtrack(solver.Level() - 1);
+        }
+    }
+    backtrack(0);
+
+    auto& profile = constraint.profile();
+    return GridResult{profile.propagate_calls, profile.calc_reason_calls, profile.undo_calls, profile.conflicts,
+                      profile.propagate_seconds, profile.calc_reason_seconds, undo_seconds};
+}
+
+double NanosPerCall(double seconds, uint64_t calls) {
+    return calls == 0 ? 0.0 : seconds * 1e9 / calls;
+}
+
+}
+
+int main(int argc, char** argv) {
+    int n_steps = 2000, max_side = 200;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string opt = argv[i];
+        if (opt == "-s") n_steps = std::atoi(argv[i + 1]);
+        else if (opt == "-n") max_side = std::atoi(argv[i + 1]);
+        else {
+            std::cerr << "usage: " << argv[0] << " [-s steps] [-n max_side]" << std::endl;
+            return 1;
+        }
+    }
+
+    for (int side : {10, 20, 50, 100, 200}) {
+        if (side > max_side) break;
+        GridResult r = RunGrid(side, RecordTrace(side, n_steps, side));
+        std::cout << side << "x" << side
+                  << " propagate " << r.n_propagate << " calls " << NanosPerCall(r.propagate_seconds, r.n_propagate) << " ns/call"
+                  << " | calcReason " << r.n_reason << " calls " << NanosPerCall(r.reason_seconds, r.n_reason) << " ns/call"
+                  << " | undo " << r.n_undo << " calls " << NanosPerCall(r.undo_seconds, r.n_undo) << " ns/call"
+                  << " | conflicts " << r.n_conflicts << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,94 @@
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "integrated/integrated.h"
+
+#include "generators.h"
+
+using namespace csugar;
+
+// Runs the generated suite and writes one JSON record per instance:
+//   csugar_bench [-o output.json] [-f family] [-t time_limit_seconds]
+
+namespace {
+
+struct BenchResult {
+    std::string family;
+    int size;
+    std::string result;  // "sat", "unsat" or "unknown"
+    double parse_seconds;
+    CSPStats stats;
+};
+
+BenchResult RunInstance(const BenchInstance& instance, double time_limit) {
+    IntegratedCSPSolver solver;
+    solver.SetTimeLimit(time_limit);
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < instance.lines.size(); ++i) {
+        solver.Parse(instance.lines[i], i + 1);
+    }
+    double parse_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    CSPAnswer answer = solver.Solve();
+    std::string result = answer.IsUnknown() ? "unknown" : (answer.IsSat() ? "sat" : "unsat");
+    return BenchResult{instance.family, instance.size, result, parse_seconds, answer.Stats()};
+}
+
+void WriteJSON(std::ostream& out, const std::vector<BenchResult>& results) {
+    out << "[\n";
+    for (int i = 0; i < results.size(); ++i) {
+        auto& r = results[i];
+        auto& s = r.stats;
+        out << "  {\"family\": \"" << r.family << "\", \"size\": " << r.size << ", \"result\": \"" << r.result << "\",\n"
+            << "   \"parse_time\": " << r.parse_seconds << ", \"convert_time\": " << s.convert_seconds
+            << ", \"propagate_time\": " << s.propagate_seconds << ", \"simplify_time\": " << s.simplify_seconds
+            << ", \"encode_time\": " << s.encode_seconds << ", \"solve_time\": " << s.solve_seconds << ",\n"
+            << "   \"icsp_bool_vars\": " << s.icsp_bool_vars << ", \"icsp_int_vars\": " << s.icsp_int_vars
+            << ", \"icsp_clauses\": " << s.icsp_clauses << ", \"sat_vars\": " << s.sat_vars
+            << ", \"sat_clauses\": " << s.sat_clauses << ", \"sat_constraints\": " << s.sat_constraints << ",\n"
+            << "   \"conflicts\": " << s.conflicts << ", \"decisions\": " << s.decisions
+            << ", \"propagations\": " << s.propagations << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "]" << std::endl;
+}
+
+}
+
+int main(int argc, char** argv) {
+    std::string output, family;
+    double time_limit = 60;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string opt = argv[i];
+        if (opt == "-o") output = argv[i + 1];
+        else if (opt == "-f") family = argv[i + 1];
+        else if (opt == "-t") time_limit = std::atof(argv[i + 1]);
+        else {
+            std::cerr << "usage: " << argv[0] << " [-o output.json] [-f family] [-t time_limit_seconds]" << std::endl;
+            return 1;
+        }
+    }
+
+    std::vector<BenchResult> results;
+    for (auto& instance : GenerateBenchSuite()) {
+        if (!family.empty() && instance.family != family) continue;
+        results.push_back(RunInstance(instance, time_limit));
+
+        auto& r = results.back();
+        std::cerr << r.family << " " << r.size << ": " << r.result << " in "
+                  << r.parse_seconds + r.stats.convert_seconds + r.stats.propagate_seconds + r.stats.simplify_seconds
+                     + r.stats.encode_seconds + r.stats.solve_seconds << "s" << std::endl;
+    }
+
+    if (output.empty()) {
+        WriteJSON(std::cout, results);
+    } else {
+        std::ofstream out(output);
+        WriteJSON(out, results);
+    }
+    return 0;
+}
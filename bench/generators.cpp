@@ -0,0 +1,253 @@
+#include "generators.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace csugar {
+
+namespace {
+
+// Fixed LCG so that the instances do not depend on the standard library
+class Random {
+public:
+    Random(uint32_t seed) : state_(seed * 2654435761u + 1) {}
+    int Next(int n) {
+        state_ = state_ * 1103515245u + 12345u;
+        return (state_ >> 16) % n;
+    }
+private:
+    uint32_t state_;
+};
+
+std::string Cell(const std::string& prefix, int r, int c) {
+    return prefix + "_" + std::to_string(r) + "_" + std::to_string(c);
+}
+std::string Join(const std::string& op, const std::vector<std::string>& args) {
+    std::string ret = "(" + op;
+    for (auto& a : args) ret += " " + a;
+    return ret + ")";
+}
+std::string CountTrue(const std::vector<std::string>& conds) {
+    std::vector<std::string> terms;
+    for (auto& c : conds) terms.push_back("(if " + c + " 1 0)");
+    return Join("+", terms);
+}
+
+}
+
+BenchInstance GenerateSudoku(int box) {
+    int n = box * box;
+    BenchInstance ret{"sudoku", n, {}};
+    Random rand(n);
+    for (int r = 0; r < n; ++r) {
+        for (int c = 0; c < n; ++c) {
+            ret.lines.push_back("(int " + Cell("x", r, c) + " 1 " + std::to_string(n) + ")");
+        }
+    }
+    for (int i = 0; i < n; ++i) {
+        std::vector<std::string> row, col, blk;
+        for (int j = 0; j < n; ++j) {
+            row.push_back(Cell("x", i, j));
+            col.push_back(Cell("x", j, i));
+            blk.push_back(Cell("x", i / box * box + j / box, i % box * box + j % box));
+        }
+        ret.lines.push_back(Join("alldifferent", row));
+        ret.lines.push_back(Join("alldifferent", col));
+        ret.lines.push_back(Join("alldifferent", blk));
+    }
+    for (int r = 0; r < n; ++r) {
+        for (int c = 0; c < n; ++c) {
+            if (rand.Next(3) != 0) continue;
+            int value = (r % box * box + r / box + c) % n + 1;
+            ret.lines.push_back("(= " + Cell("x", r, c) + " " + std::to_string(value) + ")");
+        }
+    }
+    return ret;
+}
+
+BenchInstance GenerateLatinSquare(int n) {
+    BenchInstance ret{"latin", n, {}};
+    Random rand(n);
+    for (int r = 0; r < n; ++r) {
+        for (int c = 0; c < n; ++c) {
+            ret.lines.push_back("(int " + Cell("x", r, c) + " 1 " + std::to_string(n) + ")");
+        }
+    }
+    for (int i = 0; i < n; ++i) {
+        std::vector<std::string> row, col;
+        for (int j = 0; j < n; ++j) {
+            row.push_back(Cell("x", i, j));
+            col.push_back(Cell("x", j, i));
+        }
+        ret.lines.push_back(Join("alldifferent", row));
+        ret.lines.push_back(Join("alldifferent", col));
+    }
+    for (int r = 0; r < n; ++r) {
+        for (int c = 0; c < n; ++c) {
+            if (rand.Next(5) != 0) continue;
+            ret.lines.push_back("(= " + Cell("x", r, c) + " " + std::to_string((r + c) % n + 1) + ")");
+        }
+    }
+    return ret;
+}
+
+BenchInstance GenerateKakuro(int n) {
+    // Cells (1..n, 1..n); row 0 and column 0 hold the clues. (r + 2c) % 9 + 1 has distinct values
+    // on any 9 consecutive cells of a row or a column, and runs are at most 8 long.
+    BenchInstance ret{"kakuro", n, {}};
+    auto is_white = [&](int r, int c) {
+        if (r <= 0 || c <= 0 || r > n || c > n) return false;
+        return r % 9 != 0 && c % 9 != 0 && (r * 3 + c * 5) % 7 != 0;
+    };
+    auto value = [](int r, int c) { return (r + 2 * c) % 9 + 1; };
+    for (int r = 1; r <= n; ++r) {
+        for (int c = 1; c <= n; ++c) {
+            if (is_white(r, c)) ret.lines.push_back("(int " + Cell("x", r, c) + " 1 9)");
+        }
+    }
+    for (int dir = 0; dir < 2; ++dir) {
+        for (int i = 1; i <= n; ++i) {
+            for (int j = 1; j <= n; ++j) {
+                int r = dir == 0 ? i : j, c = dir == 0 ? j : i;
+                int pr = dir == 0 ? r : r - 1, pc = dir == 0 ? c - 1 : c;
+                if (!is_white(r, c) || is_white(pr, pc)) continue;
+
+                std::vector<std::string> run;
+                int sum = 0;
+                while (is_white(r, c)) {
+                    run.push_back(Cell("x", r, c));
+                    sum += value(r, c);
+                    if (dir == 0) ++c;
+                    else ++r;
+                }
+                if (run.size() < 2) continue;
+                ret.lines.push_back(Join("alldifferent", run));
+                ret.lines.push_back("(= " + Join("+", run) + " " + std::to_string(sum) + ")");
+            }
+        }
+    }
+    return ret;
+}
+
+BenchInstance GenerateConnectedRegion(int n) {
+    // Solution: every even row and column 0 shaded (a comb); forced unshaded cells avoid it
+    BenchInstance ret{"connected_region", n, {}};
+    Random rand(n);
+    std::vector<std::string> cells;
+    for (int r = 0; r < n; ++r) {
+        for (int c = 0; c < n; ++c) {
+            cells.push_back(Cell("s", r, c));
+            ret.lines.push_back("(bool " + cells.back() + ")");
+        }
+    }
+
+    std::vector<std::string> graph = {std::to_string(n * n), "0"};
+    graph.insert(graph.end(), cells.begin(), cells.end());
+    int n_edges = 0;
+    for (int r = 0; r < n; ++r) {
+        for (int c = 0; c < n; ++c) {
+            if (r + 1 < n) {
+                graph.push_back(std::to_string(r * n + c));
+                graph.push_back(std::to_string((r + 1) * n + c));
+                ++n_edges;
+            }
+            if (c + 1 < n) {
+                graph.push_back(std::to_string(r * n + c));
+                graph.push_back(std::to_string(r * n + c + 1));
+                ++n_edges;
+            }
+        }
+    }
+    graph[1] = std::to_string(n_edges);
+    ret.lines.push_back(Join("graph-active-vertices-connected", graph));
+
+    for (int r = 0; r + 1 < n; ++r) {
+        for (int c = 0; c + 1 < n; ++c) {
+            ret.lines.push_back(Join("||", {"(! " + Cell("s", r, c) + ")", "(! " + Cell("s", r + 1, c) + ")",
+                                            "(! " + Cell("s", r, c + 1) + ")", "(! " + Cell("s", r + 1, c + 1) + ")"}));
+        }
+    }
+    for (int r = 1; r < n; r += 2) {
+        for (int c = 1; c < n; ++c) {
+            if (rand.Next(3) == 0) ret.lines.push_back("(! " + Cell("s", r, c) + ")");
+        }
+    }
+    ret.lines.push_back("(>= " + CountTrue(cells) + " " + std::to_string(n * n / 3) + ")");
+    return ret;
+}
+
+BenchInstance GenerateSlitherlink(int n) {
+    // Solution: the boundary of the cells with |2r - (n - 1)| + |2c - (n - 1)| <= n - 1
+    BenchInstance ret{"slitherlink", n, {}};
+    Random rand(n);
+    auto inside = [&](int r, int c) {
+        if (r < 0 || c < 0 || r >= n || c >= n) return false;
+        return std::abs(2 * r - (n - 1)) + std::abs(2 * c - (n - 1)) <= n - 1;
+    };
+
+    // Vertices (r, c) for 0 <= r, c <= n; h_r_c joins (r, c)-(r, c+1), v_r_c joins (r, c)-(r+1, c)
+    int n_vertices = (n + 1) * (n + 1);
+    std::vector<std::string> edges;
+    std::vector<std::pair<int, int>> ends;
+    std::vector<std::vector<std::string>> incident(n_vertices);
+    for (int r = 0; r <= n; ++r) {
+        for (int c = 0; c <= n; ++c) {
+            if (c < n) {
+                edges.push_back(Cell("h", r, c));
+                ends.push_back({r * (n + 1) + c, r * (n + 1) + c + 1});
+            }
+            if (r < n) {
+                edges.push_back(Cell("v", r, c));
+                ends.push_back({r * (n + 1) + c, (r + 1) * (n + 1) + c});
+            }
+        }
+    }
+    for (int i = 0; i < edges.size(); ++i) {
+        ret.lines.push_back("(bool " + edges[i] + ")");
+        incident[ends[i].first].push_back(edges[i]);
+        incident[ends[i].second].push_back(edges[i]);
+    }
+    for (int v = 0; v < n_vertices; ++v) {
+        std::string degree = CountTrue(incident[v]);
+        ret.lines.push_back("(|| (= " + degree + " 0) (= " + degree + " 2))");
+    }
+
+    // Graph over vertices and edges, so that connectivity runs along the loop itself
+    std::vector<std::string> graph = {std::to_string(n_vertices + edges.size()), std::to_string(2 * edges.size())};
+    for (int v = 0; v < n_vertices; ++v) graph.push_back(Join("||", incident[v]));
+    graph.insert(graph.end(), edges.begin(), edges.end());
+    for (int i = 0; i < edges.size(); ++i) {
+        graph.push_back(std::to_string(ends[i].first));
+        graph.push_back(std::to_string(n_vertices + i));
+        graph.push_back(std::to_string(ends[i].second));
+        graph.push_back(std::to_string(n_vertices + i));
+    }
+    ret.lines.push_back(Join("graph-active-vertices-connected", graph));
+
+    for (int r = 0; r < n; ++r) {
+        for (int c = 0; c < n; ++c) {
+            if (rand.Next(3) == 0) continue;
+            int clue = 0;
+            for (auto d : {std::make_pair(-1, 0), std::make_pair(1, 0), std::make_pair(0, -1), std::make_pair(0, 1)}) {
+                if (inside(r, c) != inside(r + d.first, c + d.second)) ++clue;
+            }
+            std::vector<std::string> sides = {Cell("h", r, c), Cell("h", r + 1, c), Cell("v", r, c), Cell("v", r, c + 1)};
+            ret.lines.push_back("(= " + CountTrue(sides) + " " + std::to_string(clue) + ")");
+        }
+    }
+    return ret;
+}
+
+std::vector<BenchInstance> GenerateBenchSuite() {
+    std::vector<BenchInstance> ret;
+    for (int box : {2, 3, 4}) ret.push_back(GenerateSudoku(box));
+    for (int n : {5, 8, 12}) ret.push_back(GenerateLatinSquare(n));
+    for (int n : {5, 8, 12}) ret.push_back(GenerateKakuro(n));
+    for (int n : {6, 10, 14}) ret.push_back(GenerateConnectedRegion(n));
+    for (int n : {4, 6, 8}) ret.push_back(GenerateSlitherlink(n));
+    return ret;
+}
+
+}
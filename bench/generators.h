@@ -0,0 +1,34 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace csugar {
+
+// A generated CSP in the input language of the csugar executable, one line per definition / constraint
+struct BenchInstance {
+    std::string family;
+    int size;
+    std::vector<std::string> lines;
+};
+
+// Deterministic generators: every instance is satisfiable by construction, and the same
+// (family, size) always yields the same text.
+
+// Sudoku with `box` x `box` blocks (side box^2), about a third of the cells given
+BenchInstance GenerateSudoku(int box);
+// Latin square of side `n` with a few cells given
+BenchInstance GenerateLatinSquare(int n);
+// Kakuro on an `n` x `n` board: runs of distinct digits 1..9 with given sums
+BenchInstance GenerateKakuro(int n);
+// `n` x `n` grid whose shaded cells form one connected region without 2x2 blocks,
+// with some cells forced unshaded and at least a third of the cells shaded
+BenchInstance GenerateConnectedRegion(int n);
+// Slitherlink-like loop on an `n` x `n` grid: edge variables, vertex degree 0 or 2, one connected loop,
+// and numbered cells taken from a diamond-shaped solution
+BenchInstance GenerateSlitherlink(int n);
+
+// All families at the sizes used by the benchmark
+std::vector<BenchInstance> GenerateBenchSuite();
+
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <utility>
+#include <vector>
+
+#include "minisat/core/Solver.h"
+
+namespace csugar {
+
+// Drives a native constraint directly with decisions and backtracks, in the order MiniSat would call it.
+// Used by the ActiveVerticesConnected micro-benchmark and by its tests.
+class TraceSolver : public Minisat::Solver {
+public:
+    void Decide(Minisat::Lit p) {
+        newDecisionLevel();
+        uncheckedEnqueue(p);
+    }
+    void Backtrack(int level) { cancelUntil(level); }
+    int Level() const { return decisionLevel(); }
+    int TrailSize() const { return trail.size(); }
+    Minisat::Lit TrailAt(int i) const { return trail[i]; }
+};
+
+// Edges of the `side` x `side` grid graph, where vertex (y, x) is y * side + x
+inline std::vector<std::pair<int, int>> GridEdges(int side) {
+    std::vector<std::pair<int, int>> ret;
+    for (int y = 0; y < side; ++y) {
+        for (int x = 0; x < side; ++x) {
+            if (y + 1 < side) ret.push_back({y * side + x, (y + 1) * side + x});
+            if (x + 1 < side) ret.push_back({y * side + x, y * side + x + 1});
+        }
+    }
+    return ret;
+}
+
+}
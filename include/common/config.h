@@ -7,6 +7,15 @@ struct Config {
     bool incremental_propagation = true;
     bool normalize_linearsum = true;
     bool reduce_arity = true;
+
+    // Choose the encoding of each linear literal from the estimated number of clauses instead of its domain size:
+    // the least decomposed one whose estimate is within `max_literal_clauses` is taken, otherwise the cheapest one.
+    // Split thresholds still start at `max_linearsum_size`.
+    bool use_cost_model = false;
+    long long max_literal_clauses = 1024;
+    // Upper bound on the estimated number of clauses for linear literals (0: unlimited).
+    // When it gets tight, more compact encodings are chosen.
+    long long clause_budget = 0;
 };
 
 }
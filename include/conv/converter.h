@@ -11,17 +11,42 @@
 #include "icsp/linear_sum.h"
 #include "icsp/linear_literal.h"
 #include "common/config.h"
+#include "conv/cost_model.h"
 
 namespace csugar {
 
+// What the conversion of one top-level constraint produced, besides its clauses (which carry it as their origin)
+struct ConversionNote {
+    std::vector<std::shared_ptr<ICSPBoolVar>> aux_bool_vars;
+    std::vector<std::shared_ptr<ICSPIntVar>> aux_int_vars;
+    // ReduceArity decision for each linear sum with more than 3 terms: the split threshold, or EncodingChoice::kDirect
+    std::vector<int> split_thresholds;
+};
+
 class Converter {
 public:
-    Converter(CSP& csp, ICSP &icsp) : csp_(csp), icsp_(icsp) {}
+    Converter(CSP& csp, ICSP &icsp) : csp_(csp), icsp_(icsp), estimated_clauses_(0), over_budget_(false), scoped_(false), current_origin_(-1) {}
 
     void Convert(bool incremental = false);
     Config GetConfig() const { return config_; }
     void SetCofig(const Config& config) { config_ = config; }
 
+    // Estimated number of clauses for the linear literals converted so far
+    long long EstimatedClauses() const { return estimated_clauses_; }
+    // Whether `config_.clause_budget` could not be kept even with the most compact encodings
+    bool IsOverBudget() const { return over_budget_; }
+
+    // Constraints converted while `scoped` is set may be retracted later, so they must not narrow the domains.
+    void SetScoped(bool scoped) { scoped_ = scoped; }
+    // Forgets the auxiliary variables shared between equivalent expressions (their definitions may have been retracted)
+    void ClearCache() { cache_.clear(); }
+
+    // Indexed by the position of the constraint in CSP::Exprs()
+    const std::vector<ConversionNote>& Notes() const { return notes_; }
+
+    // Returns an ICSP variable equal to the integer expression `expr`, adding its defining constraint if needed
+    std::shared_ptr<ICSPIntVar> ConvertIntExpr(std::shared_ptr<Expr> expr);
+
     std::shared_ptr<ICSPBoolVar> ConvertBoolVar(const CSPBoolVar &var) {
         if (0 <= var.id() && var.id() < bool_var_conv_.size()) {
             return bool_var_conv_[var.id()];
@@ -46,7 +71,13 @@ private:
     std::vector<Clause> ConvertComparison(std::shared_ptr<Expr> x, std::shared_ptr<Expr> y, LinearLiteralOp op);
     LinearSum ConvertFormula(std::shared_ptr<Expr> expr);
     LinearSum ReduceArity(const LinearSum &e, LinearLiteralOp op);
-    LinearSum SimplifyLinearExpression(const LinearSum& e, LinearLiteralOp op, bool first);
+    int ChooseSplitThreshold(const LinearSum &e, LinearLiteralOp op);
+    LinearSum SimplifyLinearExpression(const LinearSum& e, LinearLiteralOp op, bool first, int max_size);
+
+    // Auxiliary variables, noted for the constraint being converted
+    std::shared_ptr<ICSPBoolVar> MakeAuxBoolVar();
+    std::shared_ptr<ICSPIntVar> MakeAuxIntVar(std::unique_ptr<Domain>&& domain);
+    ConversionNote* CurrentNote() { return current_origin_ >= 0 ? &notes_[current_origin_] : nullptr; }
 
     std::shared_ptr<ICSPIntVar> GetEquivalence(std::shared_ptr<Expr> x);
     void AddEquivalence(std::shared_ptr<ICSPIntVar> v, std::shared_ptr<Expr> x);
@@ -57,6 +88,11 @@ private:
     std::vector<std::shared_ptr<ICSPBoolVar>> bool_var_conv_;
     std::vector<std::shared_ptr<ICSPIntVar>> int_var_conv_;
     Config config_;
+    long long estimated_clauses_;
+    bool over_budget_;
+    bool scoped_;
+    int current_origin_;
+    std::vector<ConversionNote> notes_;
 };
 
 }
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <vector>
+
+#include "icsp/linear_sum.h"
+#include "icsp/linear_literal.h"
+
+namespace csugar {
+
+// Estimated size of the SAT encoding of a constraint
+struct EncodingCost {
+    long long clauses = 0;
+    long long aux_vars = 0;  // SAT variables for the order encoding of auxiliary integer variables
+
+    long long Total() const;
+};
+
+// A way of encoding a linear literal: either directly, or after splitting it into auxiliary variables
+// as Converter::SimplifyLinearExpression does with the given threshold.
+struct EncodingChoice {
+    static constexpr int kDirect = -1;
+
+    int split_threshold;
+    EncodingCost cost;
+};
+
+// Estimated cost of the order encoding of `sum op 0` as Encoder would emit it.
+EncodingCost EstimateDirectEncoding(const LinearSum& sum, LinearLiteralOp op);
+
+// Candidate encodings of `sum op 0`, ordered from the least to the most decomposed one.
+// Split thresholds start at `max_linearsum_size` and are divided by 4 down to 16.
+std::vector<EncodingChoice> EnumerateEncodingChoices(const LinearSum& sum, LinearLiteralOp op, int max_linearsum_size);
+
+}
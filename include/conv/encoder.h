@@ -2,6 +2,7 @@
 
 #include <memory>
 #include <cassert>
+#include <optional>
 
 #include "icsp/icsp.h"
 #include "icsp/clause.h"
@@ -10,6 +11,7 @@
 #include "icsp/linear_literal.h"
 #include "icsp/var.h"
 #include "sat/sat.h"
+#include "sat/sink.h"
 #include "sat/satlit.h"
 #include "sat/mapping.h"
 #include "common/util.h"
@@ -23,12 +25,28 @@ struct VarSummary {
 
 class Encoder {
 public:
-    Encoder(ICSP& icsp, SAT& sat, Mapping& mapping) : icsp_(icsp), sat_(sat), mapping_(mapping) {}
+    Encoder(ICSP& icsp, SAT& sat, Mapping& mapping) : icsp_(icsp), sat_(sat), mapping_(mapping), sink_(&sat), n_threads_(1), current_origin_(-1) {}
+
+    // Emitted clauses go to `sat` unless another sink is given (e.g. the Solver itself)
+    void SetSink(SATSink* sink) { sink_ = sink; }
+
+    // With more than one thread, clauses are encoded in parallel into per-chunk buffers which are then
+    // passed to the sink in the original order, so the result is identical to the sequential encoding.
+    void SetNumThreads(int n_threads) { n_threads_ = n_threads; }
+
+    // While a guard is set, every clause from EncodeClause is emitted as (!guard || clause),
+    // so that it can be disabled later. Clauses tying int variables to their order encoding are not guarded.
+    void SetGuard(std::optional<SATLit> guard) { guard_ = guard; }
 
     void Encode(bool incremental = false);
     void EncodeBoolVar(std::shared_ptr<ICSPBoolVar> var);
     void EncodeIntVar(std::shared_ptr<ICSPIntVar> var);
     void EncodeClause(const Clause& clause);
+
+    // Numbers of SAT clauses and non-clause constraints emitted by EncodeClause so far, indexed by Clause::origin()
+    // (clauses of unknown origin are not counted). The order-encoding clauses of the variables are not included.
+    const std::vector<long long>& ClausesByOrigin() const { return clauses_by_origin_; }
+    const std::vector<long long>& ConstraintsByOrigin() const { return constraints_by_origin_; }
 private:
     SATLit GetCodeLE(std::shared_ptr<ICSPIntVar> var, int c) {
         return mapping_.GetCodeLE(var, c);
@@ -44,7 +62,22 @@ private:
         }
     }
     SATLit GetCode(std::shared_ptr<const Literal> literal);
-    void AddSATClause(const std::vector<SATLit>& clause) { sat_.AddClause(clause); }
+    void AddSATClause(const std::vector<SATLit>& clause) {
+        CountForOrigin(clauses_by_origin_);
+        if (guard_.has_value()) {
+            std::vector<SATLit> guarded = clause;
+            guarded.push_back(!guard_.value());
+            sink_->AddClause(guarded);
+        } else {
+            sink_->AddClause(clause);
+        }
+    }
+    void CountForOrigin(std::vector<long long>& counts) {
+        if (current_origin_ < 0) return;
+        if (counts.size() <= current_origin_) counts.resize(current_origin_ + 1, 0);
+        ++counts[current_origin_];
+    }
+    void MergeCounts(const Encoder& other);
     void EncodeLiteral(std::shared_ptr<Literal> literal, const std::vector<SATLit>& clause);
     void EncodeLinearLeLiteral(std::shared_ptr<LinearLiteral> literal, const std::vector<SATLit>& clause);
     void EncodeLinearNeLiteral(std::shared_ptr<LinearLiteral> literal, const std::vector<SATLit>& clause);
@@ -65,9 +98,16 @@ private:
                         std::vector<SATLit>& clause);
 
     void EncodeGraphLiteral(std::shared_ptr<GraphLiteral> literal);
+    void EncodeClausesParallel(int begin, int end);
+
     ICSP &icsp_;
     SAT &sat_;
     Mapping &mapping_;
+    SATSink *sink_;
+    int n_threads_;
+    std::optional<SATLit> guard_;
+    int current_origin_;
+    std::vector<long long> clauses_by_origin_, constraints_by_origin_;
 };
 
 }
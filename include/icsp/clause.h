@@ -13,8 +13,8 @@ namespace csugar {
 
 class Clause {
 public:
-    Clause() {}
-    Clause(std::shared_ptr<Literal> lit) { literals_.push_back(lit); }
+    Clause() : origin_(-1) {}
+    Clause(std::shared_ptr<Literal> lit) : origin_(-1) { literals_.push_back(lit); }
 
     int size() const { return literals_.size(); }
     std::shared_ptr<Literal> operator[](int i) const { return literals_[i]; }
@@ -25,6 +25,10 @@ public:
 
     bool IsSimple() const;
 
+    // Index of the top-level CSP constraint this clause was converted from (-1 if unknown)
+    int origin() const { return origin_; }
+    void SetOrigin(int origin) { origin_ = origin; }
+
     std::string str() const;
 
     std::set<std::shared_ptr<ICSPIntVar>> GetCommonIntVars() const;
@@ -34,6 +38,7 @@ public:
 
 private:
     std::vector<std::shared_ptr<Literal>> literals_;
+    int origin_;
 };
 
 }
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <vector>
+
+#include "icsp/icsp.h"
+
+namespace csugar {
+
+// Connected components of the constraint graph of an ICSP. Two variables are connected if a clause contains both,
+// through bool literals, linear literals or the vertices of a graph literal.
+// Int variables marked in `fixed_int_vars` (indexed by ICSPIntVar::id(), e.g. those with a single value
+// in the encoding) do not connect anything. They and the variables in no clause are put together into one extra component.
+struct ICSPDecomposition {
+    int n_components;
+    std::vector<int> bool_component;    // indexed by ICSPBoolVar::id()
+    std::vector<int> int_component;     // indexed by ICSPIntVar::id()
+    std::vector<int> clause_component;  // -1 for clauses without unfixed variables
+};
+
+ICSPDecomposition DecomposeICSP(const ICSP& icsp, const std::vector<bool>& fixed_int_vars);
+
+}
@@ -6,24 +6,76 @@
 #include "csp/csp.h"
 #include "csp/var.h"
 #include "icsp/icsp.h"
+#include "icsp/decomposition.h"
 #include "sat/mapping.h"
 #include "sat/sat.h"
 #include "sat/solver.h"
+#include "sat/dimacs.h"
+#include "sat/backbone.h"
+#include "sat/totalizer.h"
+#include "sat/portfolio.h"
+#include "sat/cube.h"
+#include "sat/counter.h"
+#include "sat/component.h"
 
+#include <iostream>
 #include <map>
 #include <string>
 #include <memory>
 #include <optional>
+#include <functional>
+#include <mutex>
+#include <tuple>
 
 namespace csugar {
 
 class CSPAnswer;
+struct UniquenessResult;
+struct CountResult;
+struct ConstraintReport;
+
+// Statistics of an IntegratedCSPSolver, accumulated over all of its queries.
+// The SAT search counters cover the single solver only; the parallel solve modes add their time to `solve_seconds`.
+struct CSPStats {
+    double convert_seconds = 0, propagate_seconds = 0, simplify_seconds = 0, encode_seconds = 0, solve_seconds = 0;
+    int icsp_bool_vars = 0, icsp_int_vars = 0, icsp_clauses = 0;
+    int sat_vars = 0;
+    long long sat_clauses = 0, sat_constraints = 0;
+    uint64_t conflicts = 0, decisions = 0, propagations = 0;
+    long long estimated_clauses = 0;  // by the cost model, for linear literals
+    bool over_budget = false;         // see IntegratedCSPSolver::SetClauseBudget
+    // Native constraints in the main solver; their times are measured only with SetProfileTiming(true)
+    std::vector<Minisat::ConstraintProfile> constraint_profiles;
+};
+
+// Names of the variables decoded into a CSPAnswer and their positions in CSPAnswer::Values()
+struct CSPAnswerIndex {
+    std::vector<std::string> names;
+    std::map<std::string, int> position;
+};
+
+// How the bound on the objective is tightened in IntegratedCSPSolver::Minimize/Maximize
+enum class ObjectiveSearch {
+    kLinear,      // ask for a value just better than the best one found
+    kBinary,      // bisect between the proven bound and the best value found
+    kLowerBound,  // move the proven bound one step at a time until a solution is found
+};
+
+// How Solve() runs the SAT solver
+enum class SolveMode {
+    kSingle,          // one incremental MiniSat instance
+    kPortfolio,       // diversified MiniSat instances racing on the whole problem
+    kCubeAndConquer,  // lookahead cubes solved by a pool of MiniSat instances
+    kComponents,      // independent components of the ICSP solved separately by a pool of MiniSat instances
+};
 
 class IntegratedCSPSolver {
 public:
     IntegratedCSPSolver();
 
-    void Parse(const std::string& in);
+    // `line_number` is only kept to identify the constraints of `in` in EncodingReport().
+    // Throws ParseError if `in` is malformed or is a constraint AddConstraint() refuses.
+    void Parse(const std::string& in, int line_number = -1);
 
     CSPBoolVar GetBoolVar(const std::string& name) const { return bool_var_map_.at(name); }
     CSPIntVar GetIntVar(const std::string& name) const { return int_var_map_.at(name); }
@@ -34,16 +86,177 @@ public:
     CSPBoolVar MakeBoolVar(const std::string& name);
     CSPIntVar MakeIntVar(const std::string& name, std::unique_ptr<Domain>&& domain);
 
-    void AddConstraint(std::shared_ptr<Expr> expr);
-    void SetTargetVars(const std::vector<std::string>& vars) { target_vars_ = vars; }
-    void ClearTargetVars() { target_vars_.reset(); }
+    // Returns false (and adds nothing) for a graph constraint inside a scope
+    bool AddConstraint(std::shared_ptr<Expr> expr);
+    // `expr` may be violated at the cost of `weight` (> 0)
+    void AddSoftConstraint(std::shared_ptr<Expr> expr, long long weight);
+    bool HasSoftConstraints() const { return !soft_constraints_.empty(); }
+
+    // Constraints added after Push() are retracted by the matching Pop().
+    // They are guarded by an activation literal assumed in every solve, so popping needs no rebuilding.
+    // Graph constraints are native constraints, which cannot be guarded, so they cannot be added inside a scope.
+    // Pop() returns false if no scope is open.
+    void Push();
+    bool Pop();
+    int NumScopes() const { return scopes_.size(); }
+    void SetTargetVars(const std::vector<std::string>& vars) {
+        target_vars_ = vars;
+        answer_layout_.reset();
+    }
+    void ClearTargetVars() {
+        target_vars_.reset();
+        answer_layout_.reset();
+    }
+
+    // By default, encoded clauses are streamed directly into the SAT solver.
+    // Setting this before the first Solve() keeps a copy of them in the `SAT` object as well.
+    void SetStoreSATClauses(bool store) { store_sat_clauses_ = store; }
+    void SetEncodeThreads(int n_threads) { encode_threads_ = n_threads; }
+    // Chooses the encodings of linear literals by their estimated number of clauses (Config::use_cost_model),
+    // keeping the total estimate within `clauses` if possible (0: unlimited). Must be set before the first Solve().
+    void SetClauseBudget(long long clauses) { clause_budget_ = clauses; }
+    // Whether the clause budget could not be kept even with the most compact encodings
+    bool IsOverBudget() const { return conv_ && conv_->IsOverBudget(); }
+    // Parallel modes use `n_threads` workers built from the stored clauses,
+    // so they imply SetStoreSATClauses(true) if set before the first Solve().
+    // Other queries (SolveIrrefutably, Enumerate, ...) always use the single solver.
+    void SetSolveMode(SolveMode mode, int n_threads = 1) {
+        solve_mode_ = mode;
+        solve_threads_ = n_threads;
+        portfolio_.reset();
+        cube_solver_.reset();
+        component_solver_.reset();
+    }
 
     CSPAnswer Solve();
 
+    // Statistics so far; Solve() also attaches them to its answer
+    CSPStats GetStats() const;
+    // Measures the time spent in each native constraint, which costs two clock reads per call
+    void SetProfileTiming(bool timed);
+
+    // Encodes the problem if needed, and returns the `top_n` top-level constraints with the most SAT clauses.
+    // Auxiliary variables of a constraint count towards it, including their order-encoding clauses.
+    std::vector<ConstraintReport> EncodingReport(int top_n);
+
+    // Limits for each SAT call made by a query (negative: no limit), with the time in seconds. When a limit is hit,
+    // the query stops as if interrupted (see Interrupt()); all encoded state is kept, so the solver can be used again.
+    // Limits are enforced by the single solver only (not in the parallel solve modes).
+    void SetConflictBudget(long long conflicts) { conflict_budget_ = conflicts; }
+    void SetPropagationBudget(long long propagations) { propagation_budget_ = propagations; }
+    void SetTimeLimit(double seconds) { time_limit_ = seconds; }
+    // May be called from another thread. Stops the running search of the single solver
+    // (or the next one if none is running). The query running it stops without drawing conclusions from it:
+    // answers are unknown, and the queries returning no answer report Interrupted().
+    void Interrupt();
+    // Whether the last query was stopped by an interrupt or a budget before it was decided
+    bool Interrupted() const { return interrupted_; }
+
+    // Finds the values of the target variables (all variables if not set) shared by every solution.
+    // The returned answer contains only such variables.
+    CSPAnswer SolveIrrefutably();
+
+    // Finds a solution in which the set of true bool target variables is maximal:
+    // no solution makes a strict superset of them true. Int target variables are not constrained.
+    // Each SAT call adds every target made true by its model to the set, so it takes at most one call per target.
+    // Models are not rotated (flipping a false target whose flip keeps the model valid, without a SAT call):
+    // that needs the clauses and native constraints watching the flipped variable, and in the default mode
+    // they exist only inside MiniSat.
+    CSPAnswer SolveMaximal();
+
+    // Finds a solution minimizing (maximizing) the integer expression `expr`; the answer carries the optimal value.
+    // The objective is encoded once as an int variable, and each bound (obj <= k) is passed as an assumption
+    // on its order-encoding literal, so learnt clauses are kept across bounds.
+    CSPAnswer Minimize(std::shared_ptr<Expr> expr);
+    CSPAnswer Maximize(std::shared_ptr<Expr> expr);
+    void SetObjectiveSearch(ObjectiveSearch search) { objective_search_ = search; }
+
+    // Objective given by a `(minimize e)` or `(maximize e)` line
+    bool HasObjective() const { return objective_.has_value(); }
+    CSPAnswer Optimize();
+
+    // Finds a solution minimizing the total weight of the violated soft constraints, which is given as its objective.
+    // A minimize/maximize objective is not taken into account.
+    // Uses the core-guided OLL algorithm with totalizers and weight stratification.
+    CSPAnswer SolveMaxSAT();
+
+    // Enumerates solutions which differ on the target variables (all variables if not set), passing each to `callback`.
+    // Stops when `callback` returns false or `max_solutions` solutions are found (no limit if negative).
+    // Returns the number of solutions found (so far if Interrupted()). The solver is left unrestricted afterwards.
+    int Enumerate(const std::function<bool(const CSPAnswer&)>& callback, int max_solutions = -1);
+    // Same as Enumerate, but splits the space into disjoint cubes on the target literals and enumerates
+    // each cube with its own solver on `n_threads` threads. Solutions are passed to `callback` on the
+    // calling thread, cube by cube in a fixed order, so the stream is deterministic.
+    // Needs the stored clauses (SetStoreSATClauses); otherwise this falls back to Enumerate.
+    int EnumerateParallel(const std::function<bool(const CSPAnswer&)>& callback, int max_solutions, int n_threads);
+
+    // Counts the distinct assignments to the target variables (all variables if not set) over all solutions.
+    // Counts up to `enumeration_limit` are found by enumeration with blocking clauses; larger ones by projected
+    // model counting on the order-encoding literals of the target variables. The counter needs the stored clauses
+    // (SetStoreSATClauses(true) before the first query) and no non-clause constraints; otherwise the enumeration
+    // goes on to the end.
+    // If Interrupted(), `count` is only the number of solutions enumerated so far.
+    CountResult CountSolutions(int enumeration_limit = 64);
+
+    // Checks whether the problem has exactly one solution (on the target variables) under `clues`,
+    // given as (name, value) with bool values as 0/1. Clues are passed as assumptions and do not persist,
+    // so this can be called repeatedly with different clue sets on the same encoded instance.
+    UniquenessResult CheckUniqueness(const std::vector<std::pair<std::string, int>>& clues);
+
+    // Removes redundant clues from `clues` while keeping the solution unique, and returns the remaining ones
+    // (a minimal set: dropping any of them makes the solution non-unique).
+    // Returns std::nullopt if the problem does not have a unique solution under `clues`, or if Interrupted().
+    std::optional<std::vector<std::pair<std::string, int>>> MinimizeClues(const std::vector<std::pair<std::string, int>>& clues);
+
+    // Encodes the problem (without solving it) and writes the CNF and its mapping layout.
+    // Returns false if the clauses were already streamed into the solver and are not available.
+    bool ExportDIMACS(std::ostream& cnf, std::ostream& layout);
+    // Same as ExportDIMACS, but writes a WCNF whose soft clauses are the negated relaxation literals of the soft constraints
+    bool ExportWCNF(std::ostream& wcnf, std::ostream& layout);
+    MappingLayout GetMappingLayout() const;
+
 private:
+    // Converts and encodes the constraints added so far. Returns false if the problem is found unsatisfiable.
+    bool Prepare();
+    // Prepares and solves the problem, returning the raw SAT assignment (empty if unsatisfiable)
+    std::vector<bool> SolveRaw();
+    // Solves the already prepared problem under `assumptions` (and the activation literals of the open scopes)
+    std::vector<bool> SolvePrepared(const std::vector<SATLit>& assumptions);
+    // Answer for an empty model: unknown if the last search was interrupted, unsat otherwise
+    CSPAnswer NoAnswer() const;
+    CSPAnswer SolveOptimal(std::shared_ptr<Expr> expr, bool maximize);
+
+    // Variables decoded into a CSPAnswer: bool variables first, then int variables
+    struct AnswerLayout {
+        std::shared_ptr<CSPAnswerIndex> index;
+        std::vector<std::shared_ptr<ICSPBoolVar>> bool_vars;
+        std::vector<std::shared_ptr<ICSPIntVar>> int_vars;
+    };
+    const AnswerLayout& GetAnswerLayout();
+    CSPAnswer DecodeAnswer(const std::vector<bool>& assignment);
+    // Clause excluding every assignment which agrees with `answer` on all of its variables
+    std::vector<SATLit> BlockingClause(const CSPAnswer& answer);
+    // Literals forcing variable `name` to take `value`
+    std::vector<SATLit> ValueLiterals(const std::string& name, int value);
+    // Nothing was added to the CSP or the ICSP since the last Prepare()
+    bool IsPrepared() const;
+    // Splits the encoded instance along the connected components of the ICSP and solves them in parallel
+    std::vector<bool> SolveByComponents();
+    // SAT variables of the bool and order-encoding literals of the target variables
+    std::vector<int> TargetSATVariables();
+
     std::map<std::string, CSPBoolVar> bool_var_map_;
     std::map<std::string, CSPIntVar> int_var_map_;
     std::optional<std::vector<std::string>> target_vars_;
+    bool store_sat_clauses_;
+    int encode_threads_;
+    std::optional<long long> clause_budget_;
+    SolveMode solve_mode_;
+    int solve_threads_;
+    std::optional<std::pair<std::shared_ptr<Expr>, bool>> objective_;  // (expr, maximize)
+    ObjectiveSearch objective_search_;
+    // (relaxation variable, weight); the relaxation variable is true when the soft constraint may be violated
+    std::vector<std::pair<CSPBoolVar, long long>> soft_constraints_;
 
     std::unique_ptr<CSP> csp_;
     std::unique_ptr<ICSP> icsp_;
@@ -53,25 +266,88 @@ private:
     std::unique_ptr<Mapping> mapping_;
     std::unique_ptr<Encoder> encoder_;
     std::unique_ptr<Solver> solver_;
+    std::unique_ptr<PortfolioSolver> portfolio_;
+    std::unique_ptr<CubeAndConquerSolver> cube_solver_;
+    std::unique_ptr<ComponentSolver> component_solver_;
+    std::tuple<int, int, int> component_solver_sat_size_;  // (variables, clauses, constraints) of `sat_` it was built from
+    std::vector<SATLit> scopes_;
+    std::optional<AnswerLayout> answer_layout_;
+    // Reusable encoding of "the target variables differ from a given answer" for CheckUniqueness:
+    // differs_[x] = (p, n) with p -> x and n -> !x, and difference_act_ enables the clause
+    // (!act || every p and n over difference_vars_). A call rules out the answer by assuming !p or !n.
+    std::map<int, std::pair<SATLit, SATLit>> differs_;
+    std::vector<int> difference_vars_;
+    std::optional<SATLit> difference_act_;
+
+    long long conflict_budget_, propagation_budget_;
+    double time_limit_;
+    // Guards `solver_` against Interrupt() while it is created
+    std::mutex interrupt_mutex_;
+    bool interrupt_pending_;
+    bool interrupted_;
+    bool profile_timing_;
+    CSPStats stats_;  // phase times; the sizes and SAT counters are filled in by GetStats()
+    // (input line number, text) of each constraint in CSP::Exprs(); (-1, "") if not from Parse
+    std::vector<std::pair<int, std::string>> constraint_sources_;
 };
 
 class CSPAnswer {
 public:
     bool IsSat() const { return sat_; }
+    // The search was stopped by a budget or an interrupt before it was decided
+    bool IsUnknown() const { return unknown_; }
  
     friend class IntegratedCSPSolver;
 
-    bool GetBool(const std::string& name) const { return bool_ans_.at(name); }
-    int GetInt(const std::string& name) const { return int_ans_.at(name); }
+    bool Has(const std::string& name) const { return index_ && index_->position.count(name) > 0; }
+    bool GetBool(const std::string& name) const { return values_[index_->position.at(name)] != 0; }
+    int GetInt(const std::string& name) const { return values_[index_->position.at(name)]; }
+
+    // Values of all decoded variables (bool values as 0/1) in the order of Names()
+    const std::vector<std::string>& Names() const { return index_->names; }
+    const std::vector<int>& Values() const { return values_; }
+
+    bool HasObjective() const { return objective_.has_value(); }
+    long long GetObjective() const { return objective_.value(); }
+
+    // Statistics of the solver at the time of the answer (set by IntegratedCSPSolver::Solve)
+    const CSPStats& Stats() const { return stats_; }
 
 private:
-    CSPAnswer() : sat_(false) {}
-    CSPAnswer(std::map<std::string, bool>&& bool_ans, std::map<std::string, int>&& int_ans) :
-        sat_(true), bool_ans_(std::move(bool_ans)), int_ans_(std::move(int_ans)) {}
+    CSPAnswer() : sat_(false), unknown_(false) {}
+    CSPAnswer(std::shared_ptr<const CSPAnswerIndex> index, std::vector<int>&& values) :
+        sat_(true), unknown_(false), index_(index), values_(std::move(values)) {}
+
+    bool sat_, unknown_;
+    std::shared_ptr<const CSPAnswerIndex> index_;
+    std::vector<int> values_;
+    std::optional<long long> objective_;
+    CSPStats stats_;
+};
+
+struct UniquenessResult {
+    enum Status { kUnsat, kUnique, kMultiple, kUnknown };
+
+    Status status;
+    // `first` is a solution unless kUnsat (for kUnknown, if one was found before the interrupt);
+    // for kMultiple, `second` is another solution differing from it
+    CSPAnswer first, second;
+};
+
+// Encoding cost of one top-level constraint, see IntegratedCSPSolver::EncodingReport
+struct ConstraintReport {
+    int line;  // as given to Parse (-1 if unknown)
+    std::string text;
+    int icsp_clauses, bool_literals, linear_literals, graph_literals;
+    int aux_bool_vars, aux_int_vars;
+    std::vector<int> split_thresholds;  // see ConversionNote
+    long long sat_vars, sat_clauses, sat_constraints;
+};
 
-    bool sat_;
-    std::map<std::string, bool> bool_ans_;
-    std::map<std::string, int> int_ans_;
+struct CountResult {
+    uint64_t count;        // saturates at UINT64_MAX
+    bool by_enumeration;   // false if the projected model counter was used
+    double seconds;        // wall-clock time including encoding
 };
 
 }
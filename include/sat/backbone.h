@@ -0,0 +1,19 @@
+#pragma once
+
+#include <vector>
+
+#include "sat/satlit.h"
+#include "sat/solver.h"
+
+namespace csugar {
+
+// Finds which of `candidates` are true in every model of the formula in `solver` (under `assumptions`).
+// `model` must be a model of the formula in which all of `candidates` are true.
+// Candidates are tested in chunks: a chunk is refuted at once by a model falsifying any of its literals
+// (which also filters the remaining candidates), and proved all at once when no such model exists.
+// Backbone literals found are added to the solver as clauses conditioned on `assumptions`.
+// If a search is interrupted, this stops with solver.Interrupted() set; the candidates not proved by then are false.
+std::vector<bool> ComputeBackbone(Solver& solver, const std::vector<SATLit>& candidates, const std::vector<bool>& model,
+                                  const std::vector<SATLit>& assumptions = {});
+
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "sat/sat.h"
+#include "sat/satlit.h"
+#include "minisat/core/Solver.h"
+
+namespace csugar {
+
+// Solves the clauses and constraints in `sat` as independent subproblems, given by a partition of the variables.
+// `var_component[v]` is the component of SAT variable `v`, or -1 for variables shared by all of them
+// (SAT::True() and scope guards). Each clause and constraint goes to the component of its first
+// owned variable; the components must not share any other variable.
+// Components are packed into at most `4 * n_threads` groups of similar size; each group gets its own
+// MiniSat instance, and the instances are solved on `n_threads` threads.
+class ComponentSolver {
+public:
+    ComponentSolver(const SAT& sat, const std::vector<int>& var_component, int n_components, int n_threads);
+
+    int NumGroups() const { return solvers_.size(); }
+
+    // Returns the merged model (empty if some component is unsatisfiable under `assumptions`)
+    std::vector<bool> Solve(const std::vector<SATLit>& assumptions = {});
+
+private:
+    const SAT& sat_;
+    std::vector<int> var_group_;
+    int n_threads_;
+    std::vector<std::unique_ptr<Minisat::Solver>> solvers_;
+    std::vector<long long> group_sizes_;  // number of literals, to start the larger groups first
+};
+
+}
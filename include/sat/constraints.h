@@ -15,6 +15,8 @@ public:
     virtual ~NonClauseConstraint() {}
 
     virtual std::unique_ptr<Minisat::Constraint> Emit() const = 0;
+    // Literals the constraint depends on
+    virtual std::vector<SATLit> Literals() const = 0;
 };
 
 class ActiveVerticesConnectedConstraint : public NonClauseConstraint {
@@ -30,6 +32,7 @@ public:
         }
         return std::make_unique<Minisat::ActiveVerticesConnected>(minisat_lits, edges_);
     }
+    std::vector<SATLit> Literals() const override { return lits_; }
 private:
     std::vector<SATLit> lits_;
     std::vector<std::pair<int, int>> edges_;
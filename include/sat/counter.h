@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <vector>
+
+#include "sat/sat.h"
+#include "sat/satlit.h"
+#include "minisat/core/Solver.h"
+
+namespace csugar {
+
+// Projected model counting: counts the assignments to `projection` (SAT variables) which extend to a model
+// of the clauses in `sat`. DPLL branches on projection variables only; the residual formula is split into
+// connected components, which are counted separately and cached. Whether the variables outside the
+// projection can be completed is decided by MiniSat. Non-clause constraints are not supported.
+class ProjectedCounter {
+public:
+    ProjectedCounter(const SAT& sat, const std::vector<int>& projection);
+
+    // Non-clause constraints in `sat` make counting unsupported
+    bool IsSupported() const { return supported_; }
+
+    // Counts under `assumptions`; the result saturates at UINT64_MAX. std::nullopt if !IsSupported().
+    std::optional<uint64_t> Count(const std::vector<SATLit>& assumptions = {});
+
+    long long NumDecisions() const { return n_decisions_; }
+    long long NumCacheHits() const { return n_cache_hits_; }
+
+private:
+    struct Component {
+        std::vector<int> vars;
+        std::vector<int> clauses;
+    };
+
+    int Value(int lit) const {
+        int v = value_[lit >> 1];
+        return v < 0 ? -1 : (v ^ (lit & 1));
+    }
+    bool Assume(int lit);
+    bool Propagate();
+    void Backtrack(int size);
+    bool Satisfiable();
+
+    // Product of the counts of the components of `clauses` under the current assignment,
+    // doubled for each unassigned projection variable in `vars` which no open clause contains
+    uint64_t CountSplit(const std::vector<int>& vars, const std::vector<int>& clauses);
+    uint64_t CountComponent(const Component& component);
+    int FindRoot(int var);
+
+    std::vector<std::vector<int>> clauses_;
+    std::vector<std::vector<int>> occurs_;
+    std::vector<bool> is_projection_;
+    std::vector<signed char> value_;
+    std::vector<int> trail_;
+    int qhead_, root_size_;
+    bool ok_, supported_;
+
+    std::vector<int> parent_, slot_;  // union-find over variables and the component of each root
+    Minisat::Solver solver_;
+    Minisat::vec<Minisat::Lit> decisions_;
+    std::map<std::vector<int>, uint64_t> cache_;
+    long long n_decisions_, n_cache_hits_;
+};
+
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "sat/sat.h"
+#include "sat/satlit.h"
+#include "minisat/core/Solver.h"
+
+namespace csugar {
+
+// Splits the search space of the clauses in `sat` under `assumptions` into at most `max_cubes` cubes
+// (conjunctions of literals, each including `assumptions`) by lookahead with unit propagation.
+// Branching variables are taken from `preferred_vars` while any of them is unassigned
+// (and only from them if `preferred_only` is set, e.g. to split on projection variables).
+// Cubes refuted by propagation are left out, so the cubes are disjoint and together cover every solution;
+// they are returned in depth-first order. Non-clause constraints are not looked at.
+std::vector<std::vector<SATLit>> SplitIntoCubes(const SAT& sat, const std::vector<int>& preferred_vars,
+                                                const std::vector<SATLit>& assumptions, int max_cubes,
+                                                bool preferred_only = false);
+
+// Solves the clauses in `sat` by splitting them into cubes and solving the cubes under assumptions
+// with a work-stealing pool of incremental MiniSat instances. The first satisfiable cube wins.
+// Workers persist between calls; clauses added to `sat` meanwhile are loaded incrementally.
+class CubeAndConquerSolver {
+public:
+    CubeAndConquerSolver(const SAT& sat, int n_threads);
+
+    // Variables to branch on first (e.g. the order-encoding variables of the CSP variables)
+    void SetPreferredVariables(const std::vector<int>& vars) { preferred_vars_ = vars; }
+    void SetMaxCubes(int max_cubes) { max_cubes_ = max_cubes; }
+
+    // Returns a model (empty if unsatisfiable under `assumptions`)
+    std::vector<bool> Solve(const std::vector<SATLit>& assumptions = {});
+
+private:
+    void LoadPending();
+
+    const SAT& sat_;
+    int n_threads_, max_cubes_;
+    std::vector<int> preferred_vars_;
+    std::vector<std::unique_ptr<Minisat::Solver>> workers_;
+    int loaded_clauses_, loaded_constraints_;
+};
+
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <map>
+
+#include "sat/sat.h"
+#include "sat/satlit.h"
+
+namespace csugar {
+
+// SAT variable `i` is written as DIMACS variable `i + 1`, so variable 1 is always the constant true.
+// Non-clause constraints cannot be represented in DIMACS; only their number is reported in a comment.
+void WriteDIMACS(const SAT& sat, std::ostream& out);
+
+// Clauses of `sat` are written as hard clauses; `soft_clauses` are given with their weights.
+void WriteWCNF(const SAT& sat, const std::vector<std::pair<std::vector<SATLit>, long long>>& soft_clauses, std::ostream& out);
+
+// Reads a CNF written by WriteDIMACS into a freshly constructed `sat`. Returns false on malformed input.
+bool ReadDIMACS(std::istream& in, SAT& sat);
+
+// Reads a model printed in the SAT competition format ("v 1 -2 ... 0"). Lines not starting with 'v' are ignored.
+std::vector<bool> ReadDIMACSModel(std::istream& in, int n_variables);
+
+// Layout of CSP variables over SAT variables, written next to an exported CNF
+// so that a model found by an external solver can be decoded back into CSP values.
+class MappingLayout {
+public:
+    void AddBool(const std::string& name, int var) { bool_vars_[name] = var; }
+    void AddInt(const std::string& name, const std::vector<int>& domain, int offset) { int_vars_[name] = {domain, offset}; }
+
+    bool HasBool(const std::string& name) const { return bool_vars_.count(name) > 0; }
+    bool HasInt(const std::string& name) const { return int_vars_.count(name) > 0; }
+    std::vector<std::string> BoolVars() const;
+    std::vector<std::string> IntVars() const;
+
+    // Same semantics as Mapping::Retrieve
+    bool RetrieveBool(const std::string& name, const std::vector<bool>& assignment) const;
+    int RetrieveInt(const std::string& name, const std::vector<bool>& assignment) const;
+
+    // One variable per line: "b <name> <var>" or "i <name> <offset> <domain size> <values>...",
+    // where variable indices are DIMACS (1-based) ones.
+    void Write(std::ostream& out) const;
+    bool Read(std::istream& in);
+
+private:
+    std::map<std::string, int> bool_vars_;
+    std::map<std::string, std::pair<std::vector<int>, int>> int_vars_;
+};
+
+}
@@ -2,21 +2,26 @@
 
 #include "minisat/core/Constraint.h"
 #include "minisat/core/Solver.h"
+#include "sat/profiled_constraint.h"
 
 #include <vector>
 #include <algorithm>
 
 namespace Minisat {
 
-class ActiveVerticesConnected : public Constraint {
+class ActiveVerticesConnected : public ProfiledConstraint {
 public:
     ActiveVerticesConnected(const std::vector<Lit> &lits, const std::vector<std::pair<int, int>> &edges);
     virtual ~ActiveVerticesConnected() = default;
 
-    bool initialize(Solver& solver, vec<Lit>& out_watchers) override;
-    bool propagate(Solver& solver, Lit p) override;
-    void calcReason(Solver& solver, Lit p, vec<Lit>& out_reason) override;
-    void undo(Solver& solver, Lit p) override;
+    // When false, every change is propagated by reanalyzing the whole graph (used as a reference in tests)
+    void setIncremental(bool incremental) { incremental_ = incremental; }
+
+protected:
+    bool initializeImpl(Solver& solver, vec<Lit>& out_watchers) override;
+    bool propagateImpl(Solver& solver, Lit p) override;
+    void calcReasonImpl(Solver& solver, Lit p, vec<Lit>& out_reason) override;
+    void undoImpl(Solver& solver, Lit p) override;
 
 private:
     enum NodeState {
@@ -24,10 +29,15 @@ private:
     };
     const int kUnvisited = -1;
 
+    // Reanalyzes the vertices in `vertices` (all of them, or the active cluster of the last analysis)
+    // and enqueues what follows from the result
+    bool analyze(Solver& solver, const std::vector<int>& vertices);
     int buildTree(int v, int parent, int cluster_id);
 
     std::vector<Lit> lits_;
     std::vector<std::vector<int>> adj_;
+    std::vector<std::pair<Var, int>> var_vertices_;  // (var(lits_[i]), i), sorted
+    std::vector<int> all_vertices_;
     std::vector<NodeState> state_;
     std::vector<int> decision_order_;
     std::vector<int> rank_, lowlink_, subtree_active_count_, cluster_id_, parent_;
@@ -35,6 +45,13 @@ private:
     Minisat::Lit conflict_cause_lit_;  // The conflict detected in propagate() is caused because `conflict_cause_pos_`-th variable was actually `conflict_cause_lit_`
     int conflict_cause_pos_;
     int n_active_vertices_;
+
+    // Result of the last analysis. While `analysis_valid_`, everything it implies has been enqueued and
+    // the assignments made since then did not change it: an articulation point becoming active, or
+    // a vertex outside the active cluster becoming inactive. Any undo invalidates it.
+    bool analysis_valid_, incremental_;
+    std::vector<int> cluster_vertices_, previous_cluster_;  // vertices of the active cluster (and of the one before)
+    std::vector<char> in_cluster_, is_articulation_;  // char rather than bool: they are rewritten on every analysis
 };
 
 }
@@ -1,7 +1,6 @@
 #pragma once
 
 #include <vector>
-#include <map>
 #include <memory>
 #include <algorithm>
 
@@ -11,22 +10,45 @@
 
 namespace csugar {
 
-// Class for maintaining the mapping between CSP variables and SAT variables
+// Class for maintaining the mapping between CSP variables and SAT variables.
+// Variables are indexed by their ids, and the domains of all integer variables are kept in one array.
+// Once all variables are registered, GetCode/GetCodeLE may be called from several threads at once.
 class Mapping {
 public:
     Mapping(SAT& sat) : sat_(sat) {}
     void RegisterMappingBool(std::shared_ptr<ICSPBoolVar> var);
     void RegisterMappingInt(std::shared_ptr<ICSPIntVar> var);
 
-    bool Retrieve(std::shared_ptr<ICSPBoolVar> var, const std::vector<bool> &assignment);
-    int Retrieve(std::shared_ptr<ICSPIntVar> var, const std::vector<bool> &assignment);
+    bool Retrieve(std::shared_ptr<ICSPBoolVar> var, const std::vector<bool> &assignment) const;
+    int Retrieve(std::shared_ptr<ICSPIntVar> var, const std::vector<bool> &assignment) const;
+
+    // Decodes `vars[i]` into `out[i]` (bool values as 0/1)
+    void RetrieveAll(const std::vector<std::shared_ptr<ICSPBoolVar>>& vars, const std::vector<bool> &assignment, int* out) const;
+    void RetrieveAll(const std::vector<std::shared_ptr<ICSPIntVar>>& vars, const std::vector<bool> &assignment, int* out) const;
+
+    SATLit GetCode(std::shared_ptr<ICSPBoolVar> var) const { return SATLit(bool_code_[var->id()]); }
+    SATLit GetCodeLE(std::shared_ptr<ICSPIntVar> var, int c) const;
+
+    // Layout of the order encoding: SAT variable `offset + i` stands for (var <= domain[i])
+    int GetVariable(std::shared_ptr<ICSPBoolVar> var) const { return bool_code_[var->id()]; }
+    std::vector<int> GetDomain(std::shared_ptr<ICSPIntVar> var) const;
+    int GetOffset(std::shared_ptr<ICSPIntVar> var) const { return int_info_[var->id()].offset; }
+    // All SAT variables standing for bool variables or order-encoding literals
+    std::vector<int> MappedVariables() const;
 
-    SATLit GetCode(std::shared_ptr<ICSPBoolVar> var) { return mapping_bool_[var]; }
-    SATLit GetCodeLE(std::shared_ptr<ICSPIntVar> var, int c);
 private:
+    struct IntVarInfo {
+        int offset;        // first SAT variable of the order encoding
+        int domain_begin;  // position of the domain in `domain_values_`
+        int domain_size;
+    };
+
+    int DecodeInt(const IntVarInfo& info, const std::vector<bool> &assignment) const;
+
     SAT& sat_;
-    std::map<std::shared_ptr<ICSPBoolVar>, int> mapping_bool_;
-    std::map<std::shared_ptr<ICSPIntVar>, std::pair<std::vector<int>, int>> mapping_int_;
+    std::vector<int> bool_code_;
+    std::vector<IntVarInfo> int_info_;
+    std::vector<int> domain_values_;
 };
 
 }
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "sat/sat.h"
+#include "sat/satlit.h"
+#include "minisat/core/Solver.h"
+
+namespace csugar {
+
+// Ring buffer of short clauses written by one worker and read by the others without locks.
+// Each slot carries a sequence number which is odd while the slot is being written;
+// a reader more than kCapacity clauses behind the writer skips the overwritten clauses.
+class ClauseExchange {
+public:
+    static constexpr int kCapacity = 4096;
+    static constexpr int kMaxClauseSize = 8;
+
+    ClauseExchange();
+
+    // Only the owning worker may publish. Literals are in MiniSat's integer encoding (Minisat::toInt).
+    void Publish(const std::vector<int>& lits);
+    // Appends the clauses published since `cursor` to `out` and advances `cursor`
+    void Fetch(uint64_t& cursor, std::vector<std::vector<int>>& out) const;
+
+private:
+    struct Slot {
+        std::atomic<uint64_t> seq;
+        std::atomic<int> size;
+        std::atomic<int> lits[kMaxClauseSize];
+    };
+
+    std::unique_ptr<Slot[]> slots_;
+    std::atomic<uint64_t> head_;
+};
+
+// Solves the clauses in `sat` with several diversified MiniSat instances on separate threads.
+// Workers differ in random seed, polarity and restart strategy, exchange learnt clauses of at most
+// ClauseExchange::kMaxClauseSize literals, and the first one to finish cancels the others.
+// Workers persist between calls; clauses added to `sat` meanwhile are loaded incrementally.
+class PortfolioSolver {
+public:
+    PortfolioSolver(const SAT& sat, int n_workers);
+    ~PortfolioSolver();
+
+    // Returns the model found first (empty if unsatisfiable under `assumptions`)
+    std::vector<bool> Solve(const std::vector<SATLit>& assumptions = {});
+
+private:
+    class Worker;
+
+    // Loads the clauses and constraints of `sat_` added since the last call into every worker
+    void LoadPending();
+
+    const SAT& sat_;
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::vector<std::unique_ptr<ClauseExchange>> exchanges_;
+    int loaded_clauses_, loaded_constraints_;
+};
+
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "minisat/core/Constraint.h"
+#include "minisat/core/Solver.h"
+
+#include <cstdint>
+
+namespace Minisat {
+
+// Counters of a single native constraint, accumulated over its lifetime
+struct ConstraintProfile {
+    uint64_t propagate_calls = 0, calc_reason_calls = 0, undo_calls = 0;
+    uint64_t propagations = 0;  // literals enqueued by propagate()
+    uint64_t conflicts = 0;     // propagate() calls which failed
+    uint64_t reason_literals = 0;
+    double propagate_seconds = 0, calc_reason_seconds = 0;  // only measured while timing is enabled
+
+    double AverageReasonLength() const {
+        return calc_reason_calls == 0 ? 0.0 : (double)reason_literals / calc_reason_calls;
+    }
+    ConstraintProfile& operator+=(const ConstraintProfile& other);
+};
+
+// Base class of the native constraints in src/sat/: MiniSat calls the public methods, which record
+// the profile and forward to the *Impl methods implementing the constraint.
+// The counters are always kept; reading the clock around each call is left to setTimed(true).
+class ProfiledConstraint : public Constraint {
+public:
+    bool initialize(Solver& solver, vec<Lit>& out_watchers) final;
+    bool propagate(Solver& solver, Lit p) final;
+    void calcReason(Solver& solver, Lit p, vec<Lit>& out_reason) final;
+    void undo(Solver& solver, Lit p) final;
+
+    const ConstraintProfile& profile() const { return profile_; }
+    void setTimed(bool timed) { timed_ = timed; }
+
+protected:
+    virtual bool initializeImpl(Solver& solver, vec<Lit>& out_watchers) = 0;
+    virtual bool propagateImpl(Solver& solver, Lit p) = 0;
+    virtual void calcReasonImpl(Solver& solver, Lit p, vec<Lit>& out_reason) = 0;
+    virtual void undoImpl(Solver& solver, Lit p) {}
+
+private:
+    ConstraintProfile profile_;
+    bool timed_ = false;
+};
+
+}
@@ -4,10 +4,11 @@
 
 #include "sat/satlit.h"
 #include "sat/constraints.h"
+#include "sat/sink.h"
 
 namespace csugar {
 
-class SAT {
+class SAT : public SATSink {
 public:
     SAT() : n_variables_(1), solved_variables_(0), solved_clauses_(0), solved_constraints_(0){
         clauses_.push_back({SATLit(0)});
@@ -21,8 +22,8 @@ public:
     const std::vector<SATLit>& GetClause(int i) const { return clauses_[i]; }
     const std::shared_ptr<NonClauseConstraint>& GetConstraint(int i) const { return constraints_[i]; }
     void AddVariables(int n = 1) { n_variables_ += n; }
-    void AddClause(const std::vector<SATLit>& clause) { clauses_.push_back(clause); }
-    void AddConstraint(std::shared_ptr<NonClauseConstraint> constraint) { constraints_.push_back(constraint); }
+    void AddClause(const std::vector<SATLit>& clause) override { clauses_.push_back(clause); }
+    void AddConstraint(std::shared_ptr<NonClauseConstraint> constraint) override { constraints_.push_back(constraint); }
 
     int NumSolvedVariables() const { return solved_variables_; }
     int NumSolvedClauses() const { return solved_clauses_; }
@@ -11,10 +11,10 @@ public:
 
     SATLit operator!() const { return SATLit(v_, !negative_); }
 
-    bool operator==(const SATLit& rhs) {
+    bool operator==(const SATLit& rhs) const {
         return v_ == rhs.v_ && negative_ == rhs.negative_;
     }
-    bool operator!=(const SATLit& rhs) {
+    bool operator!=(const SATLit& rhs) const {
         return !(v_ == rhs.v_ && negative_ == rhs.negative_);
     }
 
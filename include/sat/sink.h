@@ -0,0 +1,58 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+
+#include "sat/satlit.h"
+#include "sat/constraints.h"
+
+namespace csugar {
+
+// Destination of the clauses and non-clause constraints emitted by Encoder
+class SATSink {
+public:
+    virtual ~SATSink() {}
+
+    virtual void AddClause(const std::vector<SATLit>& clause) = 0;
+    virtual void AddConstraint(std::shared_ptr<NonClauseConstraint> constraint) = 0;
+};
+
+// Sink which discards everything but the size of the emitted instance
+class SATCountingSink : public SATSink {
+public:
+    SATCountingSink() : n_clauses_(0), n_literals_(0), n_constraints_(0) {}
+
+    void AddClause(const std::vector<SATLit>& clause) override {
+        ++n_clauses_;
+        n_literals_ += clause.size();
+    }
+    void AddConstraint(std::shared_ptr<NonClauseConstraint> constraint) override {
+        ++n_constraints_;
+    }
+
+    long long NumClauses() const { return n_clauses_; }
+    long long NumLiterals() const { return n_literals_; }
+    long long NumConstraints() const { return n_constraints_; }
+
+private:
+    long long n_clauses_, n_literals_, n_constraints_;
+};
+
+// Sink which keeps the emitted clauses and constraints so that they can be passed to another sink later
+class SATBufferSink : public SATSink {
+public:
+    void AddClause(const std::vector<SATLit>& clause) override { clauses_.push_back(clause); }
+    void AddConstraint(std::shared_ptr<NonClauseConstraint> constraint) override { constraints_.push_back(constraint); }
+
+    // Clauses and constraints are passed in the order they were added
+    void ReplayInto(SATSink& sink) const {
+        for (auto& c : clauses_) sink.AddClause(c);
+        for (auto& c : constraints_) sink.AddConstraint(c);
+    }
+
+private:
+    std::vector<std::vector<SATLit>> clauses_;
+    std::vector<std::shared_ptr<NonClauseConstraint>> constraints_;
+};
+
+}
@@ -2,21 +2,90 @@
 
 #include <vector>
 #include <memory>
+#include <mutex>
+#include <condition_variable>
 
 #include "sat/sat.h"
+#include "sat/sink.h"
 #include "minisat/core/Solver.h"
+#include "sat/profiled_constraint.h"
 
 namespace csugar {
 
-class Solver {
+// Helpers shared by everything that drives a MiniSat instance.
+// A clause containing SAT::True() is skipped, and SAT::False() literals are dropped.
+void AddClauseToMinisat(Minisat::Solver& solver, const std::vector<SATLit>& clause);
+std::vector<bool> ExtractMinisatModel(const Minisat::Solver& solver, int n_variables);
+
+// Totals over the lifetime of a Solver
+struct SolverStats {
+    long long clauses = 0, constraints = 0;  // given to MiniSat
+    uint64_t conflicts = 0, decisions = 0, propagations = 0;
+    double seconds = 0;  // spent in the search
+    // One entry per native constraint, in the order they were given to the solver
+    std::vector<Minisat::ConstraintProfile> constraint_profiles;
+};
+
+class Solver : public SATSink {
 public:
-    Solver(SAT &sat) : sat_(sat), actual_solver_(nullptr) {}
+    Solver(SAT &sat) : sat_(sat), actual_solver_(nullptr), interrupted_(false), profile_timing_(false),
+        conflict_budget_(-1), propagation_budget_(-1), time_limit_(-1), running_(false), interrupt_requested_(false) {}
+
+    // Clauses given through the sink interface go directly into MiniSat and are not stored in `sat_`.
+    // Variables are still allocated through `sat_`.
+    void AddClause(const std::vector<SATLit>& clause) override;
+    void AddConstraint(std::shared_ptr<NonClauseConstraint> constraint) override;
 
     std::vector<bool> Solve(bool incremental = false);
 
+    // Solves incrementally with each of `assumptions` forced to be true.
+    // Returns an empty vector if unsatisfiable; then Conflict() gives the assumptions responsible for it.
+    std::vector<bool> SolveUnder(const std::vector<SATLit>& assumptions);
+    const std::vector<SATLit>& Conflict() const { return conflict_; }
+
+    // Limits for each following Solve/SolveUnder call (negative: no limit), with the time in seconds.
+    // When a limit is hit or Interrupt() is called, the call returns an empty vector and Interrupted() is true;
+    // the solver keeps its state and can be used again.
+    void SetBudget(long long conflicts, long long propagations, double seconds) {
+        conflict_budget_ = conflicts;
+        propagation_budget_ = propagations;
+        time_limit_ = seconds;
+    }
+    void ClearBudget() { SetBudget(-1, -1, -1); }
+    // May be called from another thread. Stops the running call, or the next one if none is running.
+    void Interrupt();
+    bool Interrupted() const { return interrupted_; }
+
+    SolverStats Stats() const;
+    // Whether the native constraints also measure the time of their calls (their counters are always kept)
+    void SetProfileTiming(bool timed);
+
+    // Allocates a fresh SAT variable (e.g. for an activation literal)
+    SATLit NewVariable();
+
 private:
+    void PrepareSolver();
+    // Loads the clauses and constraints in `sat_` not given to the solver yet. Returns false on conflict.
+    bool LoadPending(bool incremental);
+    Minisat::lbool SolveLimited(const Minisat::vec<Minisat::Lit>& assumptions);
+    void AddConstraintToMinisat(const NonClauseConstraint& constraint);
+    void FoldProfiles();
+
     SAT &sat_;
     std::unique_ptr<Minisat::Solver> actual_solver_;
+    std::vector<SATLit> conflict_;
+    bool interrupted_;
+    SolverStats stats_;
+    // Constraints living in `actual_solver_`; their profiles are folded into `stats_` when it is rebuilt
+    std::vector<Minisat::ProfiledConstraint*> profiled_;
+    bool profile_timing_;
+
+    long long conflict_budget_, propagation_budget_;
+    double time_limit_;
+    // Guard `running_` and `interrupt_requested_`, which are shared with Interrupt() and the watchdog
+    std::mutex mutex_;
+    std::condition_variable finished_;
+    bool running_, interrupt_requested_;
 };
 
 }
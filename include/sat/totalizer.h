@@ -0,0 +1,26 @@
+#pragma once
+
+#include <vector>
+
+#include "sat/satlit.h"
+#include "sat/solver.h"
+
+namespace csugar {
+
+// Unary counter over `inputs` built as a tree of totalizer nodes.
+// AtLeast(k) is forced true whenever at least k inputs are true (1 <= k <= size()).
+// Only this direction is encoded, which is what bounding the count from above with !AtLeast(k) needs.
+class Totalizer {
+public:
+    Totalizer(Solver& solver, const std::vector<SATLit>& inputs);
+
+    int size() const { return outputs_.size(); }
+    SATLit AtLeast(int k) const { return outputs_[k - 1]; }
+
+private:
+    std::vector<SATLit> Build(Solver& solver, const std::vector<SATLit>& inputs, int begin, int end);
+
+    std::vector<SATLit> outputs_;
+};
+
+}
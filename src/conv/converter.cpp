@@ -20,16 +20,30 @@ void Converter::Convert(bool incremental) {
     }
     auto& exprs = csp_.Exprs();
     int start_index = incremental ? csp_.NumConvertedExprs() : 0;
+    notes_.resize(exprs.size());
     for (int i = start_index; i < exprs.size(); ++i) {
+        current_origin_ = i;
         ConvertConstraint(exprs[i]);
     }
+    current_origin_ = -1;
     csp_.SetAllConverted();
 }
+std::shared_ptr<ICSPIntVar> Converter::ConvertIntExpr(std::shared_ptr<Expr> expr) {
+    LinearSum e = ConvertFormula(expr);
+    if (e.size() == 1 && e.GetB() == 0) {
+        auto [v, a] = e.GetCoefs()[0];
+        if (a == 1) return v;
+    }
+    auto v = MakeAuxIntVar(e.GetDomain());
+    ConvertConstraint(Expr::Eq(Expr::InternalVarInt(v), e.ToExpr()));
+    return v;
+}
 void Converter::ConvertConstraint(std::shared_ptr<Expr> expr) {
     std::vector<Clause> clauses = ConvertConstraint(expr, false, true);
     for (auto&& c : clauses) {
+        c.SetOrigin(current_origin_);
         icsp_.AddClause(c);
-        if (config_.incremental_propagation) {
+        if (config_.incremental_propagation && !scoped_) {
             icsp_.GetClause(icsp_.NumClauses() - 1).Propagate();
         }
     }
@@ -117,7 +131,7 @@ std::vector<Clause> Converter::ConvertDisj(std::shared_ptr<Expr> expr, bool nega
                     aux_clause.Add(c[j]);
                 }
             } else {
-                auto v = icsp_.MakeBoolVar();
+                auto v = MakeAuxBoolVar();
                 auto v0 = std::make_shared<BoolLiteral>(v, false);
                 auto v1 = std::make_shared<BoolLiteral>(v, true);
                 aux_clause.Add(v0);
@@ -170,7 +184,7 @@ std::shared_ptr<Literal> Converter::ConvertGraphConstraints(std::shared_ptr<Expr
                 vars.push_back(ConvertBoolVar((*e)[0]->AsBoolVar()));
                 is_negative.push_back(true);
             } else {
-                auto v = icsp_.MakeBoolVar();
+                auto v = MakeAuxBoolVar();
                 ConvertConstraint(Expr::Make(kIff, { Expr::InternalVarBool(v), e }));
                 vars.push_back(v);
                 is_negative.push_back(false);
@@ -225,6 +239,7 @@ std::vector<Clause> Converter::ConvertComparison(std::shared_ptr<Expr> x, std::s
     LinearSum e = ConvertFormula(Expr::Make(kSub, {x, y}));
     e.Factorize();
     e = ReduceArity(e, op);
+    estimated_clauses_ += EstimateDirectEncoding(e, op).clauses;
 
     std::shared_ptr<Literal> lit = std::make_shared<LinearLiteral>(e, op);
     std::vector<Clause> ret;
@@ -291,7 +306,7 @@ LinearSum Converter::ConvertFormula(std::shared_ptr<Expr> expr) {
         LinearSum s2 = ConvertFormula(x2), s3 = ConvertFormula(x3);
         std::unique_ptr<Domain> d2 = s2.GetDomain(), d3 = s3.GetDomain();
         std::unique_ptr<Domain> d = d2->Cup(d3);
-        auto v = icsp_.MakeIntVar(std::move(d));
+        auto v = MakeAuxIntVar(std::move(d));
         auto x = Expr::InternalVarInt(v);
         auto eq = Expr::And(Expr::Or(Expr::Not(x1), Expr::Eq(x, x2)), Expr::Or(x1, Expr::Eq(x, x3)));
         ConvertConstraint(eq);
@@ -306,14 +321,42 @@ LinearSum Converter::ConvertFormula(std::shared_ptr<Expr> expr) {
 }
 LinearSum Converter::ReduceArity(const LinearSum &e, LinearLiteralOp op) {
     if (!config_.reduce_arity) return e;
-    if (e.size() <= 3 || e.GetExpectedDomainSize(true) <= config_.max_linearsum_size) {
-        return e;
+    if (e.size() <= 3) return e;
+
+    int max_size = config_.max_linearsum_size;
+    if (config_.use_cost_model) {
+        max_size = ChooseSplitThreshold(e, op);
+    } else if (e.GetExpectedDomainSize(true) <= max_size) {
+        max_size = EncodingChoice::kDirect;
     }
-    return SimplifyLinearExpression(e, op, true);
+    if (ConversionNote* note = CurrentNote()) note->split_thresholds.push_back(max_size);
+    if (max_size == EncodingChoice::kDirect) return e;
+    return SimplifyLinearExpression(e, op, true, max_size);
 }
-LinearSum Converter::SimplifyLinearExpression(const LinearSum& e, LinearLiteralOp op, bool first) {
+int Converter::ChooseSplitThreshold(const LinearSum &e, LinearLiteralOp op) {
+    std::vector<EncodingChoice> choices = EnumerateEncodingChoices(e, op, config_.max_linearsum_size);
+
+    long long allowance = config_.max_literal_clauses;
+    long long remaining = config_.clause_budget - estimated_clauses_;
+    if (config_.clause_budget > 0) {
+        // do not let a single literal take more than half of the remaining budget
+        allowance = std::min(allowance, remaining / 2);
+    }
+    for (auto& c : choices) {
+        if (c.cost.clauses <= allowance) return c.split_threshold;
+    }
+
+    auto cheapest = std::min_element(choices.begin(), choices.end(), [](const EncodingChoice& a, const EncodingChoice& b) {
+        return a.cost.Total() < b.cost.Total();
+    });
+    if (config_.clause_budget > 0 && cheapest->cost.clauses > remaining) {
+        over_budget_ = true;
+    }
+    return cheapest->split_threshold;
+}
+LinearSum Converter::SimplifyLinearExpression(const LinearSum& e, LinearLiteralOp op, bool first, int max_size) {
     if (e.size() <= 1) return e;
-    if (e.GetExpectedDomainSize(false) <= config_.max_linearsum_size) return e;
+    if (e.GetExpectedDomainSize(false) <= max_size) return e;
 
     int b = e.GetB();
     auto es = e.Split(first ? 3 : 2); // TODO: parameterize
@@ -325,9 +368,10 @@ LinearSum Converter::SimplifyLinearExpression(const LinearSum& e, LinearLiteralO
         if (factor > 1) {
             ei.Divide(factor);
         }
-        ei = SimplifyLinearExpression(ei, kLitEq, false);
+        ei = SimplifyLinearExpression(ei, kLitEq, false, max_size);
         if (ei.size() > 1) {
-            auto v = icsp_.MakeIntVar(ei.GetDomain());
+            auto v = MakeAuxIntVar(ei.GetDomain());
+            estimated_clauses_ += std::max(0, v->domain()->size() - 2);
             auto ei_expr = ei.ToExpr();
             
             ExprType type;
@@ -345,6 +389,16 @@ LinearSum Converter::SimplifyLinearExpression(const LinearSum& e, LinearLiteralO
     }
     return ret;
 }
+std::shared_ptr<ICSPBoolVar> Converter::MakeAuxBoolVar() {
+    auto v = icsp_.MakeBoolVar();
+    if (ConversionNote* note = CurrentNote()) note->aux_bool_vars.push_back(v);
+    return v;
+}
+std::shared_ptr<ICSPIntVar> Converter::MakeAuxIntVar(std::unique_ptr<Domain>&& domain) {
+    auto v = icsp_.MakeIntVar(std::move(domain));
+    if (ConversionNote* note = CurrentNote()) note->aux_int_vars.push_back(v);
+    return v;
+}
 std::shared_ptr<ICSPIntVar> Converter::GetEquivalence(std::shared_ptr<Expr> x) {
     uint64_t hash = x->Hash();
     if (cache_.count(hash) > 0) {
@@ -0,0 +1,148 @@
+#include "conv/cost_model.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+namespace csugar {
+
+namespace {
+
+const long long kCostLimit = 1LL << 60;
+
+long long SaturatingAdd(long long a, long long b) {
+    return std::min(kCostLimit, a + b);
+}
+long long SaturatingMul(long long a, long long b) {
+    if (a == 0 || b == 0) return 0;
+    if (a > kCostLimit / b) return kCostLimit;
+    return a * b;
+}
+long long Gcd(long long a, long long b) {
+    a = std::abs(a);
+    b = std::abs(b);
+    while (b > 0) {
+        long long tmp = a % b;
+        a = b;
+        b = tmp;
+    }
+    return a;
+}
+
+// A term `coef * x` of a linear sum, only as far as the cost estimation needs it
+struct Term {
+    long long size, lb, ub, coef;
+    int id;
+};
+
+bool TermOrder(const Term& l, const Term& r) {
+    return l.size < r.size || (l.size == r.size && l.id < r.id);
+}
+
+long long EstimateDirectClauses(std::vector<Term> terms, LinearLiteralOp op) {
+    if (terms.size() <= 1) return 1;
+    std::sort(terms.begin(), terms.end(), TermOrder);
+    long long ret = 1;
+    for (int i = 0; i + 1 < terms.size(); ++i) {
+        ret = SaturatingMul(ret, op == kLitNe ? terms[i].size : terms[i].size + 1);
+    }
+    if (op == kLitEq) ret = SaturatingMul(ret, 2);
+    return ret;
+}
+
+long long ExpectedDomainSize(const std::vector<Term>& terms) {
+    long long ret = 1;
+    for (auto& t : terms) ret = SaturatingMul(ret, t.size);
+    return ret;
+}
+
+// Mirrors Converter::SimplifyLinearExpression; returns the terms of the resulting sum
+std::vector<Term> EstimateSplit(std::vector<Term> terms, LinearLiteralOp op, bool first, int max_size, int& next_id, EncodingCost& cost) {
+    if (terms.size() <= 1) return terms;
+    if (ExpectedDomainSize(terms) <= max_size) return terms;
+
+    std::sort(terms.begin(), terms.end(), TermOrder);
+    int s = first ? 3 : 2;
+    std::vector<std::vector<Term>> parts(s);
+    for (int i = 0; i < terms.size(); ++i) {
+        parts[i % s].push_back(terms[i]);
+    }
+
+    std::vector<Term> ret;
+    for (auto& part : parts) {
+        if (part.empty()) continue;
+        long long factor = 0;
+        for (auto& t : part) factor = Gcd(factor, t.coef);
+        for (auto& t : part) t.coef /= factor;
+
+        std::vector<Term> sub = EstimateSplit(part, kLitEq, false, max_size, next_id, cost);
+        if (sub.size() > 1) {
+            long long lo = 0, hi = 0;
+            for (auto& t : sub) {
+                if (t.coef > 0) {
+                    lo += t.coef * t.lb;
+                    hi += t.coef * t.ub;
+                } else {
+                    lo += t.coef * t.ub;
+                    hi += t.coef * t.lb;
+                }
+            }
+            Term v{hi - lo + 1, lo, hi, factor, next_id++};
+
+            // ladder of the new variable and its defining constraint
+            cost.aux_vars = SaturatingAdd(cost.aux_vars, v.size - 1);
+            cost.clauses = SaturatingAdd(cost.clauses, std::max(0LL, v.size - 2));
+            std::vector<Term> def = sub;
+            def.push_back(v);
+            cost.clauses = SaturatingAdd(cost.clauses, EstimateDirectClauses(def, op == kLitEq || op == kLitNe ? kLitEq : kLitLe));
+            ret.push_back(v);
+        } else {
+            for (auto t : sub) {
+                t.coef *= factor;
+                ret.push_back(t);
+            }
+        }
+    }
+    return ret;
+}
+
+std::vector<Term> ToTerms(const LinearSum& sum) {
+    std::vector<Term> ret;
+    for (auto& v : sum.GetVariablesSorted()) {
+        auto& domain = v->domain();
+        ret.push_back(Term{domain->size(), domain->GetLowerBound(), domain->GetUpperBound(), sum.GetCoef(v), v->id()});
+    }
+    return ret;
+}
+
+}
+
+long long EncodingCost::Total() const {
+    return SaturatingAdd(clauses, aux_vars);
+}
+
+EncodingCost EstimateDirectEncoding(const LinearSum& sum, LinearLiteralOp op) {
+    EncodingCost ret;
+    ret.clauses = EstimateDirectClauses(ToTerms(sum), op);
+    return ret;
+}
+
+std::vector<EncodingChoice> EnumerateEncodingChoices(const LinearSum& sum, LinearLiteralOp op, int max_linearsum_size) {
+    std::vector<EncodingChoice> ret;
+    std::vector<Term> terms = ToTerms(sum);
+    ret.push_back(EncodingChoice{EncodingChoice::kDirect, EstimateDirectEncoding(sum, op)});
+
+    int max_id = 0;
+    for (auto& t : terms) max_id = std::max(max_id, t.id);
+
+    for (int threshold = max_linearsum_size; threshold >= 16; threshold /= 4) {
+        EncodingChoice choice{threshold, EncodingCost()};
+        int next_id = max_id + 1;
+        std::vector<Term> reduced = EstimateSplit(terms, op, true, threshold, next_id, choice.cost);
+        choice.cost.clauses = SaturatingAdd(choice.cost.clauses, EstimateDirectClauses(reduced, op));
+        ret.push_back(choice);
+    }
+    return ret;
+}
+
+}
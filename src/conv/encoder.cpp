@@ -1,7 +1,10 @@
 #include "conv/encoder.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <mutex>
+#include <thread>
 
 #include "icsp/clause.h"
 #include "icsp/bool_literal.h"
@@ -20,11 +23,57 @@ void Encoder::Encode(bool incremental) {
     for (int i = incremental ? icsp_.NumEncodedIntVars() : 0; i < icsp_.NumIntVars(); ++i) {
         EncodeIntVar(icsp_.GetIntVar(i));
     }
-    for (int i = incremental ? icsp_.NumEncodedClauses() : 0; i < icsp_.NumClauses(); ++i) {
-        EncodeClause(icsp_.GetClause(i));
+    int clause_begin = incremental ? icsp_.NumEncodedClauses() : 0;
+    if (n_threads_ > 1) {
+        EncodeClausesParallel(clause_begin, icsp_.NumClauses());
+    } else {
+        for (int i = clause_begin; i < icsp_.NumClauses(); ++i) {
+            EncodeClause(icsp_.GetClause(i));
+        }
     }
     icsp_.SetAllEncoded();
 }
+void Encoder::EncodeClausesParallel(int begin, int end) {
+    const int kChunkSize = 256;
+    int n_chunks = (end - begin + kChunkSize - 1) / kChunkSize;
+    std::vector<SATBufferSink> buffers(n_chunks);
+    std::atomic<int> next_chunk(0);
+    std::mutex count_mutex;
+
+    // All variables are registered in `mapping_` at this point, so workers only read it
+    auto worker = [&]() {
+        Encoder encoder(icsp_, sat_, mapping_);
+        encoder.SetGuard(guard_);
+        while (true) {
+            int chunk = next_chunk++;
+            if (chunk >= n_chunks) break;
+            encoder.SetSink(&buffers[chunk]);
+            int chunk_end = std::min(end, begin + (chunk + 1) * kChunkSize);
+            for (int i = begin + chunk * kChunkSize; i < chunk_end; ++i) {
+                encoder.EncodeClause(icsp_.GetClause(i));
+            }
+        }
+        std::lock_guard<std::mutex> lock(count_mutex);
+        MergeCounts(encoder);
+    };
+    std::vector<std::thread> threads;
+    for (int i = 0; i < std::min(n_threads_, n_chunks); ++i) {
+        threads.emplace_back(worker);
+    }
+    for (auto& t : threads) t.join();
+
+    for (auto& buffer : buffers) {
+        buffer.ReplayInto(*sink_);
+    }
+}
+void Encoder::MergeCounts(const Encoder& other) {
+    auto merge = [](std::vector<long long>& to, const std::vector<long long>& from) {
+        if (to.size() < from.size()) to.resize(from.size(), 0);
+        for (int i = 0; i < from.size(); ++i) to[i] += from[i];
+    };
+    merge(clauses_by_origin_, other.clauses_by_origin_);
+    merge(constraints_by_origin_, other.constraints_by_origin_);
+}
 void Encoder::EncodeBoolVar(std::shared_ptr<ICSPBoolVar> var) {
     mapping_.RegisterMappingBool(var);
 }
@@ -34,13 +83,14 @@ void Encoder::EncodeIntVar(std::shared_ptr<ICSPIntVar> var) {
 
     std::vector<int> domain = var->domain()->Enumerate();
     for (int i = 1; i < domain.size(); ++i) {
-        AddSATClause({
+        sink_->AddClause({
             !GetCodeLE(var, domain[i - 1]),
             GetCodeLE(var, domain[i])
         });
     }
 }
 void Encoder::EncodeClause(const Clause& clause) {
+    current_origin_ = clause.origin();
     // check validity
     if (!clause.IsSimple()) {
         // TODO: error
@@ -276,6 +326,10 @@ void Encoder::EncodeLinearNe(const std::vector<int>& as,
     }
 }
 void Encoder::EncodeGraphLiteral(std::shared_ptr<GraphLiteral> literal) {
+    if (guard_.has_value()) {
+        // TODO: non-clause constraints cannot be guarded (IntegratedCSPSolver refuses them inside a scope)
+        abort();
+    }
     if (literal->kind() == kActiveVerticesConnectedLiteral) {
         std::vector<SATLit> vars;
         for (int i = 0; i < literal->vars().size(); ++i) {
@@ -283,7 +337,8 @@ void Encoder::EncodeGraphLiteral(std::shared_ptr<GraphLiteral> literal) {
             if (literal->is_negative()[i]) lit = !lit;
             vars.push_back(lit);
         }
-        sat_.AddConstraint(std::make_shared<ActiveVerticesConnectedConstraint>(vars, literal->edges()));
+        sink_->AddConstraint(std::make_shared<ActiveVerticesConnectedConstraint>(vars, literal->edges()));
+        CountForOrigin(constraints_by_origin_);
     }
 }
 }
@@ -25,6 +25,7 @@ std::vector<Clause> Simplifier::Simplify(Clause &clause) {
         new_clauses.push_back(clause);
     } else {
         Clause c;
+        c.SetOrigin(clause.origin());
         for (int i = 0; i < clause.size(); ++i) {
             auto lit = clause[i];
             if (lit->IsSimple()) {
@@ -37,6 +38,7 @@ std::vector<Clause> Simplifier::Simplify(Clause &clause) {
 
                 // TODO: equiv translation
                 Clause c2;
+                c2.SetOrigin(clause.origin());
                 c2.Add(neg);
                 c2.Add(lit);
                 new_clauses.push_back(c2);
@@ -0,0 +1,87 @@
+#include "icsp/decomposition.h"
+
+#include <memory>
+
+#include "icsp/bool_literal.h"
+#include "icsp/graph_literal.h"
+
+namespace csugar {
+
+namespace {
+
+class UnionFind {
+public:
+    explicit UnionFind(int n) : parent_(n, -1) {}
+
+    int Root(int x) {
+        while (parent_[x] >= 0) {
+            if (parent_[parent_[x]] >= 0) parent_[x] = parent_[parent_[x]];
+            x = parent_[x];
+        }
+        return x;
+    }
+    void Join(int x, int y) {
+        x = Root(x);
+        y = Root(y);
+        if (x == y) return;
+        if (parent_[x] > parent_[y]) std::swap(x, y);
+        parent_[x] += parent_[y];
+        parent_[y] = x;
+    }
+
+private:
+    std::vector<int> parent_;  // negative size for roots
+};
+
+}
+
+ICSPDecomposition DecomposeICSP(const ICSP& icsp, const std::vector<bool>& fixed_int_vars) {
+    // Bool variable `i` is node `i` and int variable `i` is node `n_bool + i`
+    int n_bool = icsp.NumBoolVars(), n_int = icsp.NumIntVars();
+    UnionFind uf(n_bool + n_int);
+    std::vector<bool> used(n_bool + n_int, false);
+    std::vector<int> clause_node(icsp.NumClauses(), -1);
+
+    for (int i = 0; i < icsp.NumClauses(); ++i) {
+        const Clause& clause = icsp.GetClause(i);
+        std::vector<int> nodes;
+        for (int j = 0; j < clause.size(); ++j) {
+            std::shared_ptr<Literal> lit = clause[j];
+            if (auto bool_lit = std::dynamic_pointer_cast<BoolLiteral>(lit)) {
+                nodes.push_back(bool_lit->var()->id());
+            } else if (auto graph_lit = std::dynamic_pointer_cast<GraphLiteral>(lit)) {
+                for (auto& var : graph_lit->vars()) nodes.push_back(var->id());
+            } else {
+                for (auto& var : lit->IntVars()) {
+                    // a fixed variable does not link the clauses it occurs in (e.g. clue cells shared by subpuzzles)
+                    if (!fixed_int_vars[var->id()]) nodes.push_back(n_bool + var->id());
+                }
+            }
+        }
+        for (int node : nodes) {
+            used[node] = true;
+            uf.Join(nodes[0], node);
+        }
+        if (!nodes.empty()) clause_node[i] = nodes[0];
+    }
+
+    ICSPDecomposition ret;
+    ret.n_components = 0;
+    std::vector<int> component_of_root(n_bool + n_int, -1);
+    int unused_component = -1;
+    auto component = [&](int node) {
+        if (!used[node]) {
+            if (unused_component == -1) unused_component = ret.n_components++;
+            return unused_component;
+        }
+        int root = uf.Root(node);
+        if (component_of_root[root] == -1) component_of_root[root] = ret.n_components++;
+        return component_of_root[root];
+    };
+    for (int i = 0; i < n_bool; ++i) ret.bool_component.push_back(component(i));
+    for (int i = 0; i < n_int; ++i) ret.int_component.push_back(component(n_bool + i));
+    for (int node : clause_node) ret.clause_component.push_back(node == -1 ? -1 : component(node));
+    return ret;
+}
+
+}
@@ -1,9 +1,19 @@
 #include "integrated/integrated.h"
 
 #include <iostream>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
 
 #include "common/enumerative_domain.h"
 #include "csp/parser.h"
+#include "icsp/bool_literal.h"
+#include "icsp/graph_literal.h"
+#include "icsp/linear_literal.h"
 
 namespace {
 std::vector<std::string> Tokenize(const std::string& s) {
@@ -30,14 +40,37 @@ bool IsBoolDefinition(const std::string& s) {
 bool IsIntDefinition(const std::string& s) {
     return s.substr(0, 4) == "(int";
 }
+bool IsSoftConstraint(const std::string& s) {
+    return s.substr(0, 6) == "(soft ";
+}
+bool IsMinimizeDirective(const std::string& s) {
+    return s.substr(0, 10) == "(minimize ";
+}
+bool IsMaximizeDirective(const std::string& s) {
+    return s.substr(0, 10) == "(maximize ";
+}
+
+// Runs `f` and adds its wall time to `seconds`
+template <class F>
+auto Timed(double& seconds, F f) {
+    auto start = std::chrono::steady_clock::now();
+    struct Finish {
+        double& seconds;
+        std::chrono::steady_clock::time_point start;
+        ~Finish() { seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(); }
+    } finish{seconds, start};
+    return f();
+}
 }
 
 namespace csugar {
 
 IntegratedCSPSolver::IntegratedCSPSolver() :
-    bool_var_map_(), int_var_map_(), csp_(new CSP()), icsp_(nullptr), sat_(nullptr), conv_(nullptr), simplifier_(nullptr), encoder_(nullptr) {}
+    bool_var_map_(), int_var_map_(), store_sat_clauses_(false), encode_threads_(1), solve_mode_(SolveMode::kSingle), solve_threads_(1), objective_search_(ObjectiveSearch::kBinary), csp_(new CSP()), icsp_(nullptr), sat_(nullptr), conv_(nullptr), simplifier_(nullptr), encoder_(nullptr),
+    conflict_budget_(-1), propagation_budget_(-1), time_limit_(-1), interrupt_pending_(false), interrupted_(false), profile_timing_(false) {}
 
-void IntegratedCSPSolver::Parse(const std::string& in) {
+void IntegratedCSPSolver::Parse(const std::string& in, int line_number) {
+    int first_expr = csp_->Exprs().size();
     if (IsBoolDefinition(in)) {
         auto toks = SplitDepthOneExpr(in);
         if (toks.size() != 2) {
@@ -54,8 +87,36 @@ void IntegratedCSPSolver::Parse(const std::string& in) {
             exit(1);
         }
         MakeIntVar(toks[1], std::make_unique<EnumerativeDomain>(std::stoi(toks[2]), std::stoi(toks[3])));
+    } else if (IsSoftConstraint(in)) {
+        // (soft weight expr)
+        size_t weight_end = in.find(' ', 6);
+        if (weight_end == std::string::npos) {
+            throw ParseError("invalid soft constraint");
+        }
+        std::string weight_str = in.substr(6, weight_end - 6);
+        if (weight_str.empty() || weight_str.find_first_not_of("0123456789") != std::string::npos) {
+            throw ParseError("invalid soft constraint weight");
+        }
+        long long weight;
+        try {
+            weight = std::stoll(weight_str);
+        } catch (const std::out_of_range&) {
+            throw ParseError("soft constraint weight out of range");
+        }
+        if (weight == 0) {
+            throw ParseError("invalid soft constraint weight");
+        }
+        AddSoftConstraint(StringToExpr(in.substr(weight_end + 1, (int)in.size() - weight_end - 2), bool_var_map_, int_var_map_), weight);
+    } else if (IsMinimizeDirective(in) || IsMaximizeDirective(in)) {
+        auto expr = StringToExpr(in.substr(10, (int)in.size() - 11), bool_var_map_, int_var_map_);
+        objective_ = std::make_pair(expr, IsMaximizeDirective(in));
     } else {
-        AddConstraint(StringToExpr(in, bool_var_map_, int_var_map_));
+        if (!AddConstraint(StringToExpr(in, bool_var_map_, int_var_map_))) {
+            throw ParseError("graph constraints cannot be added inside a scope");
+        }
+    }
+    for (int i = first_expr; i < csp_->Exprs().size(); ++i) {
+        constraint_sources_[i] = {line_number, in};
     }
 }
 std::vector<std::string> IntegratedCSPSolver::BoolVars() const {
@@ -79,6 +140,7 @@ CSPBoolVar IntegratedCSPSolver::MakeBoolVar(const std::string& name) {
     }
     CSPBoolVar ret = csp_->MakeBoolVar();
     bool_var_map_[name] = ret;
+    answer_layout_.reset();
     return ret;
 }
 CSPIntVar IntegratedCSPSolver::MakeIntVar(const std::string& name, std::unique_ptr<Domain>&& domain) {
@@ -88,60 +150,923 @@ CSPIntVar IntegratedCSPSolver::MakeIntVar(const std::string& name, std::unique_p
     }
     CSPIntVar ret = csp_->MakeIntVar(std::move(domain));
     int_var_map_[name] = ret;
+    answer_layout_.reset();
     return ret;
 }
-void IntegratedCSPSolver::AddConstraint(std::shared_ptr<Expr> expr) {
+bool IntegratedCSPSolver::AddConstraint(std::shared_ptr<Expr> expr) {
+    if (!scopes_.empty() && expr->type() == kGraphActiveVerticesConnected) {
+        return false;
+    }
     csp_->AddExpr(expr);
+    constraint_sources_.push_back({-1, ""});
+    return true;
 }
-CSPAnswer IntegratedCSPSolver::Solve() {
+void IntegratedCSPSolver::AddSoftConstraint(std::shared_ptr<Expr> expr, long long weight) {
+    CSPBoolVar relax = csp_->MakeBoolVar();
+    csp_->AddExpr(Expr::Make(kOr, {Expr::VarBool(relax), expr}));
+    constraint_sources_.push_back({-1, ""});
+    soft_constraints_.push_back({relax, weight});
+}
+bool IntegratedCSPSolver::Prepare() {
     bool incremental = static_cast<bool>(icsp_);
+    interrupted_ = false;
+    if (IsPrepared()) {
+        return !icsp_->IsUnsatisfiable();
+    }
 
     if (!incremental) {
         icsp_ = std::make_unique<ICSP>();
         sat_ = std::make_unique<SAT>();
         mapping_ = std::make_unique<Mapping>(*sat_);
         conv_ = std::make_unique<Converter>(*csp_, *icsp_);
+        if (clause_budget_) {
+            Config config = conv_->GetConfig();
+            config.use_cost_model = true;
+            config.clause_budget = *clause_budget_;
+            conv_->SetCofig(config);
+        }
         simplifier_ = std::make_unique<Simplifier>(*icsp_);
         encoder_ = std::make_unique<Encoder>(*icsp_, *sat_, *mapping_);
-        solver_ = std::make_unique<Solver>(*sat_);
+        {
+            std::lock_guard<std::mutex> lock(interrupt_mutex_);
+            solver_ = std::make_unique<Solver>(*sat_);
+            solver_->SetProfileTiming(profile_timing_);
+            if (interrupt_pending_) solver_->Interrupt();
+            interrupt_pending_ = false;
+        }
+        if (solve_mode_ != SolveMode::kSingle) store_sat_clauses_ = true;
+        if (!store_sat_clauses_) encoder_->SetSink(solver_.get());
     }
+    encoder_->SetNumThreads(encode_threads_);
 
-    conv_->Convert(incremental);
-    if (!incremental) icsp_->Propagate();
-    simplifier_->Simplify(incremental);
+    Timed(stats_.convert_seconds, [&]() { conv_->Convert(incremental); });
+    if (!incremental) Timed(stats_.propagate_seconds, [&]() { icsp_->Propagate(); });
+    Timed(stats_.simplify_seconds, [&]() { simplifier_->Simplify(incremental); });
 
     if (icsp_->IsUnsatisfiable()) {
-        return CSPAnswer();
+        return false;
+    }
+
+    Timed(stats_.encode_seconds, [&]() { encoder_->Encode(incremental); });
+    return true;
+}
+bool IntegratedCSPSolver::IsPrepared() const {
+    return icsp_ &&
+        csp_->NumConvertedExprs() == static_cast<int>(csp_->Exprs().size()) &&
+        csp_->NumConvertedBoolVars() == csp_->NumBoolVars() &&
+        csp_->NumConvertedIntVars() == csp_->NumIntVars() &&
+        icsp_->NumEncodedClauses() == icsp_->NumClauses() &&
+        icsp_->NumEncodedBoolVars() == icsp_->NumBoolVars() &&
+        icsp_->NumEncodedIntVars() == icsp_->NumIntVars();
+}
+std::vector<bool> IntegratedCSPSolver::SolveRaw() {
+    if (!Prepare()) {
+        return std::vector<bool>();
+    }
+    // The single solver measures its own search time
+    if (solve_mode_ == SolveMode::kPortfolio && store_sat_clauses_) {
+        if (!portfolio_) portfolio_ = std::make_unique<PortfolioSolver>(*sat_, solve_threads_);
+        return Timed(stats_.solve_seconds, [&]() { return portfolio_->Solve(scopes_); });
+    }
+    if (solve_mode_ == SolveMode::kCubeAndConquer && store_sat_clauses_) {
+        if (!cube_solver_) cube_solver_ = std::make_unique<CubeAndConquerSolver>(*sat_, solve_threads_);
+        cube_solver_->SetPreferredVariables(mapping_->MappedVariables());
+        return Timed(stats_.solve_seconds, [&]() { return cube_solver_->Solve(scopes_); });
+    }
+    if (solve_mode_ == SolveMode::kComponents && store_sat_clauses_) {
+        return Timed(stats_.solve_seconds, [&]() { return SolveByComponents(); });
+    }
+    return SolvePrepared({});
+}
+std::vector<bool> IntegratedCSPSolver::SolveByComponents() {
+    // Reuse the MiniSat instances of the components until the SAT instance grows
+    std::tuple<int, int, int> sat_size(sat_->NumVariables(), sat_->NumClauses(), sat_->NumConstraints());
+    if (component_solver_ && component_solver_sat_size_ == sat_size) {
+        return component_solver_->Solve(scopes_);
     }
 
-    encoder_->Encode(incremental);
-    auto answer_raw = solver_->Solve(incremental);
+    // The ICSP is taken after propagation and simplification, which often cut apart
+    // subproblems linked in the CSP (e.g. through fixed clue cells).
+    // Fixedness is decided by the encoded domains: a later Parse may narrow the ICSP domain of a variable
+    // whose order literals are already in the clauses, and such a variable still links them.
+    std::vector<bool> fixed_int_vars(icsp_->NumIntVars());
+    for (int i = 0; i < icsp_->NumIntVars(); ++i) {
+        auto var = icsp_->GetIntVar(i);
+        fixed_int_vars[var->id()] = mapping_->GetDomain(var).size() <= 1;
+    }
+    ICSPDecomposition decomposition = DecomposeICSP(*icsp_, fixed_int_vars);
+    std::vector<int> var_component(sat_->NumVariables(), -1);
+    for (int i = 0; i < icsp_->NumBoolVars(); ++i) {
+        auto var = icsp_->GetBoolVar(i);
+        var_component[mapping_->GetVariable(var)] = decomposition.bool_component[var->id()];
+    }
+    for (int i = 0; i < icsp_->NumIntVars(); ++i) {
+        auto var = icsp_->GetIntVar(i);
+        int offset = mapping_->GetOffset(var), size = mapping_->GetDomain(var).size();
+        for (int j = 0; j < size - 1; ++j) {
+            var_component[offset + j] = decomposition.int_component[var->id()];
+        }
+    }
+    component_solver_ = std::make_unique<ComponentSolver>(*sat_, var_component, decomposition.n_components, solve_threads_);
+    component_solver_sat_size_ = sat_size;
+    return component_solver_->Solve(scopes_);
+}
+std::vector<bool> IntegratedCSPSolver::SolvePrepared(const std::vector<SATLit>& assumptions) {
+    // Always solve incrementally: streamed clauses and the solver-level clauses added by the
+    // methods below exist only in the MiniSat instance, so it must not be rebuilt from `sat_`
+    std::vector<SATLit> all_assumptions = scopes_;
+    all_assumptions.insert(all_assumptions.end(), assumptions.begin(), assumptions.end());
+    solver_->SetBudget(conflict_budget_, propagation_budget_, time_limit_);
+    std::vector<bool> ret = solver_->SolveUnder(all_assumptions);
+    solver_->ClearBudget();
+    interrupted_ = solver_->Interrupted();
+    return ret;
+}
+CSPAnswer IntegratedCSPSolver::NoAnswer() const {
+    CSPAnswer ret;
+    ret.unknown_ = interrupted_;
+    return ret;
+}
+void IntegratedCSPSolver::Push() {
+    // Constraints added so far belong to the enclosing scope
+    if (!Prepare()) {
+        // Nothing is encoded once the problem is unsatisfiable; the scope is only kept for the matching Pop()
+        scopes_.push_back(SAT::True());
+        return;
+    }
+    SATLit guard = solver_->NewVariable();
+    scopes_.push_back(guard);
+    encoder_->SetGuard(guard);
+    conv_->SetScoped(true);
+}
+bool IntegratedCSPSolver::Pop() {
+    if (scopes_.empty()) {
+        return false;
+    }
+    if (Prepare()) {
+        solver_->AddClause({!scopes_.back()});
+    }
+    scopes_.pop_back();
+    if (scopes_.empty()) {
+        encoder_->SetGuard(std::nullopt);
+        conv_->SetScoped(false);
+    } else {
+        encoder_->SetGuard(scopes_.back());
+    }
+    conv_->ClearCache();
+    return true;
+}
+CSPAnswer IntegratedCSPSolver::Solve() {
+    auto answer_raw = SolveRaw();
     if (answer_raw.size() == 0) {
+        CSPAnswer ret = NoAnswer();
+        ret.stats_ = GetStats();
+        return ret;
+    }
+
+    CSPAnswer ret = DecodeAnswer(answer_raw);
+    ret.stats_ = GetStats();
+    return ret;
+}
+CSPStats IntegratedCSPSolver::GetStats() const {
+    CSPStats ret = stats_;
+    if (!icsp_) return ret;
+
+    ret.icsp_bool_vars = icsp_->NumBoolVars();
+    ret.icsp_int_vars = icsp_->NumIntVars();
+    ret.icsp_clauses = icsp_->NumClauses();
+    ret.sat_vars = sat_->NumVariables();
+    SolverStats solver_stats = solver_->Stats();
+    if (store_sat_clauses_) {
+        ret.sat_clauses = sat_->NumClauses();
+        ret.sat_constraints = sat_->NumConstraints();
+    } else {
+        ret.sat_clauses = solver_stats.clauses;
+        ret.sat_constraints = solver_stats.constraints;
+    }
+    ret.solve_seconds += solver_stats.seconds;
+    ret.conflicts = solver_stats.conflicts;
+    ret.decisions = solver_stats.decisions;
+    ret.propagations = solver_stats.propagations;
+    ret.estimated_clauses = conv_->EstimatedClauses();
+    ret.over_budget = conv_->IsOverBudget();
+    ret.constraint_profiles = solver_stats.constraint_profiles;
+    return ret;
+}
+void IntegratedCSPSolver::SetProfileTiming(bool timed) {
+    profile_timing_ = timed;
+    if (solver_) solver_->SetProfileTiming(timed);
+}
+std::vector<ConstraintReport> IntegratedCSPSolver::EncodingReport(int top_n) {
+    Prepare();
+
+    const std::vector<ConversionNote>& notes = conv_->Notes();
+    std::vector<ConstraintReport> reports(notes.size());
+    for (int i = 0; i < notes.size(); ++i) {
+        ConstraintReport& r = reports[i];
+        r = ConstraintReport{constraint_sources_[i].first, constraint_sources_[i].second, 0, 0, 0, 0,
+                             (int)notes[i].aux_bool_vars.size(), (int)notes[i].aux_int_vars.size(),
+                             notes[i].split_thresholds, 0, 0, 0};
+        r.sat_vars = r.aux_bool_vars;
+        for (auto& var : notes[i].aux_int_vars) {
+            if (!var->IsEncoded()) continue;
+            int n = (int)mapping_->GetDomain(var).size() - 1;
+            r.sat_vars += n;
+            r.sat_clauses += n;
+        }
+    }
+    for (int i = 0; i < icsp_->NumClauses(); ++i) {
+        const Clause& clause = icsp_->GetClause(i);
+        if (clause.origin() < 0 || clause.origin() >= reports.size()) continue;
+        ConstraintReport& r = reports[clause.origin()];
+        ++r.icsp_clauses;
+        for (int j = 0; j < clause.size(); ++j) {
+            if (std::dynamic_pointer_cast<BoolLiteral>(clause[j])) ++r.bool_literals;
+            else if (std::dynamic_pointer_cast<LinearLiteral>(clause[j])) ++r.linear_literals;
+            else if (std::dynamic_pointer_cast<GraphLiteral>(clause[j])) ++r.graph_literals;
+        }
+    }
+    const std::vector<long long>& clauses = encoder_->ClausesByOrigin();
+    const std::vector<long long>& constraints = encoder_->ConstraintsByOrigin();
+    for (int i = 0; i < reports.size(); ++i) {
+        if (i < clauses.size()) reports[i].sat_clauses += clauses[i];
+        if (i < constraints.size()) reports[i].sat_constraints += constraints[i];
+    }
+
+    std::stable_sort(reports.begin(), reports.end(), [](const ConstraintReport& a, const ConstraintReport& b) {
+        return a.sat_clauses > b.sat_clauses;
+    });
+    if (reports.size() > top_n) reports.resize(top_n);
+    return reports;
+}
+void IntegratedCSPSolver::Interrupt() {
+    std::lock_guard<std::mutex> lock(interrupt_mutex_);
+    if (solver_) solver_->Interrupt();
+    else interrupt_pending_ = true;
+}
+CSPAnswer IntegratedCSPSolver::SolveIrrefutably() {
+    auto model = SolveRaw();
+    if (model.size() == 0) {
+        return NoAnswer();
+    }
+    CSPAnswer answer = DecodeAnswer(model);
+    const AnswerLayout& layout = GetAnswerLayout();
+    const std::vector<int>& values = answer.Values();
+    int n_bool = layout.bool_vars.size();
+
+    // A bool variable is fixed if its literal is a backbone; an int variable with value v
+    // is fixed if both (x <= v) and !(x <= v-1) are.
+    std::vector<SATLit> candidates;
+    for (int i = 0; i < n_bool; ++i) {
+        SATLit lit = mapping_->GetCode(layout.bool_vars[i]);
+        candidates.push_back(values[i] ? lit : !lit);
+    }
+    for (int i = 0; i < layout.int_vars.size(); ++i) {
+        int v = values[n_bool + i];
+        candidates.push_back(mapping_->GetCodeLE(layout.int_vars[i], v));
+        candidates.push_back(!mapping_->GetCodeLE(layout.int_vars[i], v - 1));
+    }
+    std::vector<bool> backbone = ComputeBackbone(*solver_, candidates, model, scopes_);
+    interrupted_ = solver_->Interrupted();
+    if (interrupted_) {
+        return NoAnswer();
+    }
+
+    auto index = std::make_shared<CSPAnswerIndex>();
+    std::vector<int> fixed_values;
+    for (int i = 0; i < layout.index->names.size(); ++i) {
+        bool fixed = i < n_bool ? backbone[i] : (backbone[n_bool + (i - n_bool) * 2] && backbone[n_bool + (i - n_bool) * 2 + 1]);
+        if (fixed) {
+            const std::string& name = layout.index->names[i];
+            index->position[name] = index->names.size();
+            index->names.push_back(name);
+            fixed_values.push_back(values[i]);
+        }
+    }
+    return CSPAnswer(index, std::move(fixed_values));
+}
+CSPAnswer IntegratedCSPSolver::Minimize(std::shared_ptr<Expr> expr) {
+    return SolveOptimal(expr, false);
+}
+CSPAnswer IntegratedCSPSolver::Maximize(std::shared_ptr<Expr> expr) {
+    return SolveOptimal(expr, true);
+}
+CSPAnswer IntegratedCSPSolver::Optimize() {
+    if (!objective_.has_value()) {
+        // TODO
+        abort();
+    }
+    return SolveOptimal(objective_->first, objective_->second);
+}
+CSPAnswer IntegratedCSPSolver::SolveOptimal(std::shared_ptr<Expr> expr, bool maximize) {
+    // Maximization minimizes -expr
+    if (!Prepare()) {
+        return CSPAnswer();
+    }
+    auto obj = conv_->ConvertIntExpr(maximize ? Expr::Make(kSub, expr) : expr);
+    if (!Prepare()) {
         return CSPAnswer();
     }
+    auto model = SolvePrepared({});
+    if (model.size() == 0) {
+        return NoAnswer();
+    }
 
-    std::map<std::string, bool> bool_ans;
-    std::map<std::string, int> int_ans;
+    // Invariant: no solution has obj < lb, and `model` has obj == best
+    int best = mapping_->Retrieve(obj, model);
+    int lb = mapping_->GetDomain(obj)[0];
+    while (lb < best) {
+        int k;
+        switch (objective_search_) {
+        case ObjectiveSearch::kLinear:
+            k = best - 1;
+            break;
+        case ObjectiveSearch::kBinary:
+            k = lb + (best - 1 - lb) / 2;
+            break;
+        case ObjectiveSearch::kLowerBound:
+            k = lb;
+            break;
+        }
+        SATLit bound = mapping_->GetCodeLE(obj, k);
+        auto next_model = SolvePrepared({bound});
+        if (interrupted_) {
+            return NoAnswer();
+        } else if (next_model.size() == 0) {
+            // obj > k is now implied (within the open scopes); keeping it helps the later bounds
+            std::vector<SATLit> clause{!bound};
+            for (SATLit g : scopes_) clause.push_back(!g);
+            solver_->AddClause(clause);
+            lb = k + 1;
+        } else {
+            model = std::move(next_model);
+            best = mapping_->Retrieve(obj, model);
+        }
+    }
+
+    CSPAnswer ret = DecodeAnswer(model);
+    ret.objective_ = maximize ? -best : best;
+    return ret;
+}
+CSPAnswer IntegratedCSPSolver::SolveMaxSAT() {
+    if (!Prepare()) {
+        return CSPAnswer();
+    }
+
+    // Each soft literal is assumed true unless its weight has been used up by the cores.
+    // When a totalizer output !(count >= bound) is in a core, !(count >= bound + 1) gets the core's weight.
+    struct SoftLit {
+        SATLit lit;
+        long long weight;
+        int totalizer;
+        int bound;
+    };
+    std::vector<SoftLit> softs;
+    long long threshold = 1;
+    for (auto& soft : soft_constraints_) {
+        softs.push_back({!mapping_->GetCode(conv_->ConvertBoolVar(soft.first)), soft.second, -1, 0});
+        threshold = std::max(threshold, soft.second);
+    }
+    std::vector<Totalizer> totalizers;
+    std::map<std::pair<int, int>, int> output_to_soft;  // (totalizer, bound) -> index in `softs`
+    long long lower_bound = 0;
+
+    while (true) {
+        std::vector<SATLit> assumptions;
+        std::map<int, int> var_to_soft;
+        for (int i = 0; i < softs.size(); ++i) {
+            if (softs[i].weight > 0 && softs[i].weight >= threshold) {
+                assumptions.push_back(softs[i].lit);
+                var_to_soft[softs[i].lit.GetVariable()] = i;
+            }
+        }
+
+        auto model = SolvePrepared(assumptions);
+        if (model.size() > 0) {
+            // Stratification: move on to the next smaller weight, or stop if every soft literal was assumed
+            long long next_threshold = 0;
+            for (auto& soft : softs) {
+                if (soft.weight > 0 && soft.weight < threshold) next_threshold = std::max(next_threshold, soft.weight);
+            }
+            if (next_threshold == 0) {
+                CSPAnswer ret = DecodeAnswer(model);
+                ret.objective_ = lower_bound;
+                return ret;
+            }
+            threshold = next_threshold;
+            continue;
+        }
+
+        if (interrupted_) {
+            return NoAnswer();
+        }
+        std::vector<int> core;
+        for (SATLit lit : solver_->Conflict()) {
+            auto it = var_to_soft.find(lit.GetVariable());
+            if (it != var_to_soft.end()) core.push_back(it->second);
+        }
+        if (core.empty()) {
+            // the hard constraints are unsatisfiable
+            return CSPAnswer();
+        }
+
+        long long core_weight = softs[core[0]].weight;
+        for (int i : core) core_weight = std::min(core_weight, softs[i].weight);
+        lower_bound += core_weight;
+
+        auto add_output = [&](int t, int bound) {
+            auto it = output_to_soft.find({t, bound});
+            if (it != output_to_soft.end()) {
+                softs[it->second].weight += core_weight;
+            } else {
+                output_to_soft[{t, bound}] = softs.size();
+                softs.push_back({!totalizers[t].AtLeast(bound), core_weight, t, bound});
+            }
+        };
+        std::vector<SATLit> violated;
+        for (int i : core) {
+            softs[i].weight -= core_weight;
+            violated.push_back(!softs[i].lit);
+            int t = softs[i].totalizer;
+            if (t >= 0 && softs[i].bound < totalizers[t].size()) {
+                add_output(t, softs[i].bound + 1);
+            }
+        }
+        // At least one literal of the core is violated; each further one costs `core_weight` again
+        if (violated.size() > 1) {
+            totalizers.emplace_back(*solver_, violated);
+            add_output(totalizers.size() - 1, 2);
+        }
+    }
+}
+CSPAnswer IntegratedCSPSolver::SolveMaximal() {
+    auto model = SolveRaw();
+    if (model.size() == 0) {
+        return NoAnswer();
+    }
+    const AnswerLayout& layout = GetAnswerLayout();
+    std::vector<SATLit> lits;
+    for (auto& var : layout.bool_vars) {
+        lits.push_back(mapping_->GetCode(var));
+    }
+
+    // Each model grows the true set by all literals it makes true; then at least one of
+    // the remaining literals is required (guarded by `act`) until that becomes unsatisfiable.
+    while (true) {
+        std::vector<SATLit> assumptions, rest;
+        for (SATLit lit : lits) {
+            if (model[lit.GetVariable()]) {
+                assumptions.push_back(lit);
+            } else {
+                rest.push_back(lit);
+            }
+        }
+        if (rest.empty()) break;
+
+        SATLit act = solver_->NewVariable();
+        rest.push_back(!act);
+        solver_->AddClause(rest);
+        assumptions.push_back(act);
+        auto next_model = SolvePrepared(assumptions);
+        solver_->AddClause({!act});
+        if (interrupted_) return NoAnswer();
+        if (next_model.size() == 0) break;
+        model = std::move(next_model);
+    }
+    return DecodeAnswer(model);
+}
+int IntegratedCSPSolver::Enumerate(const std::function<bool(const CSPAnswer&)>& callback, int max_solutions) {
+    auto model = SolveRaw();
+    if (model.size() == 0 || max_solutions == 0) {
+        return 0;
+    }
+
+    // Blocking clauses are conditioned on `guard`, which is disabled once the enumeration ends
+    SATLit guard = solver_->NewVariable();
+    int n_solutions = 0;
+    while (true) {
+        CSPAnswer answer = DecodeAnswer(model);
+        ++n_solutions;
+        if (!callback(answer) || n_solutions == max_solutions) break;
+
+        std::vector<SATLit> clause = BlockingClause(answer);
+        clause.push_back(!guard);
+        solver_->AddClause(clause);
+
+        model = SolvePrepared({guard});
+        if (model.size() == 0) break;
+    }
+    solver_->AddClause({!guard});
+    return n_solutions;
+}
+UniquenessResult IntegratedCSPSolver::CheckUniqueness(const std::vector<std::pair<std::string, int>>& clues) {
+    if (!Prepare()) {
+        return UniquenessResult{UniquenessResult::kUnsat, CSPAnswer(), CSPAnswer()};
+    }
+    std::vector<SATLit> assumptions;
+    for (auto& clue : clues) {
+        auto lits = ValueLiterals(clue.first, clue.second);
+        assumptions.insert(assumptions.end(), lits.begin(), lits.end());
+    }
+    auto model = SolvePrepared(assumptions);
+    if (model.size() == 0) {
+        return UniquenessResult{interrupted_ ? UniquenessResult::kUnknown : UniquenessResult::kUnsat, CSPAnswer(), CSPAnswer()};
+    }
+    CSPAnswer first = DecodeAnswer(model);
+
+    // Rebuild the activation clause only when the target variables changed
+    std::vector<int> vars = TargetSATVariables();
+    if (!difference_act_ || vars != difference_vars_) {
+        if (difference_act_) solver_->AddClause({!*difference_act_});
+        SATLit act = solver_->NewVariable();
+        std::vector<SATLit> clause{!act};
+        for (int x : vars) {
+            auto it = differs_.find(x);
+            if (it == differs_.end()) {
+                SATLit p = solver_->NewVariable(), n = solver_->NewVariable();
+                solver_->AddClause({!p, SATLit(x)});
+                solver_->AddClause({!n, !SATLit(x)});
+                it = differs_.emplace(x, std::make_pair(p, n)).first;
+            }
+            clause.push_back(it->second.first);
+            clause.push_back(it->second.second);
+        }
+        solver_->AddClause(clause);
+        difference_act_ = act;
+        difference_vars_ = std::move(vars);
+    }
+    assumptions.push_back(*difference_act_);
+    for (int x : difference_vars_) {
+        auto& d = differs_.at(x);
+        assumptions.push_back(model[x] ? !d.first : !d.second);
+    }
+    model = SolvePrepared(assumptions);
+
+    if (model.size() == 0) {
+        return UniquenessResult{interrupted_ ? UniquenessResult::kUnknown : UniquenessResult::kUnique, first, CSPAnswer()};
+    }
+    return UniquenessResult{UniquenessResult::kMultiple, first, DecodeAnswer(model)};
+}
+std::optional<std::vector<std::pair<std::string, int>>> IntegratedCSPSolver::MinimizeClues(const std::vector<std::pair<std::string, int>>& clues) {
+    if (!Prepare()) {
+        return std::nullopt;
+    }
+    int n_clues = clues.size();
+
+    // clue i is enabled by assuming selectors[i]
+    std::vector<SATLit> selectors;
+    std::vector<std::vector<SATLit>> clue_lits;
+    std::map<int, int> selector_to_clue;
+    for (int i = 0; i < n_clues; ++i) {
+        SATLit sel = solver_->NewVariable();
+        selectors.push_back(sel);
+        selector_to_clue[sel.GetVariable()] = i;
+        clue_lits.push_back(ValueLiterals(clues[i].first, clues[i].second));
+        for (SATLit lit : clue_lits[i]) {
+            solver_->AddClause({!sel, lit});
+        }
+    }
+    auto cleanup = [&]() {
+        for (SATLit sel : selectors) solver_->AddClause({!sel});
+    };
+
+    auto solution_model = SolvePrepared(selectors);
+    if (solution_model.size() == 0) {
+        cleanup();
+        return std::nullopt;
+    }
+
+    // The solution is unique under a clue subset iff excluding it (enabled by `block`) is unsatisfiable
+    SATLit block = solver_->NewVariable();
+    std::vector<SATLit> clause = BlockingClause(DecodeAnswer(solution_model));
+    clause.push_back(!block);
+    solver_->AddClause(clause);
+
+    // status of each clue: 0 = undecided, 1 = critical, -1 = removed
+    std::vector<int> status(n_clues, 0);
+    auto solve_without = [&](int excluded) {
+        std::vector<SATLit> assumptions{block};
+        for (int i = 0; i < n_clues; ++i) {
+            if (status[i] >= 0 && i != excluded) assumptions.push_back(selectors[i]);
+        }
+        return SolvePrepared(assumptions);
+    };
+    // On unsat, clues whose selectors are not in the final conflict are redundant
+    auto refine_by_core = [&]() {
+        std::vector<bool> in_core(n_clues, false);
+        for (SATLit lit : solver_->Conflict()) {
+            auto it = selector_to_clue.find(lit.GetVariable());
+            if (it != selector_to_clue.end()) in_core[it->second] = true;
+        }
+        for (int i = 0; i < n_clues; ++i) {
+            if (status[i] == 0 && !in_core[i]) status[i] = -1;
+        }
+    };
+    // Clues implied by the critical clues alone are redundant; they are found all at once as a backbone
+    auto remove_implied = [&]() {
+        std::vector<SATLit> assumptions = scopes_, candidates;
+        std::vector<int> candidate_clue;
+        for (int i = 0; i < n_clues; ++i) {
+            if (status[i] == 1) {
+                assumptions.push_back(selectors[i]);
+            } else if (status[i] == 0) {
+                for (SATLit lit : clue_lits[i]) {
+                    candidates.push_back(lit);
+                    candidate_clue.push_back(i);
+                }
+            }
+        }
+        std::vector<bool> backbone = ComputeBackbone(*solver_, candidates, solution_model, assumptions);
+        interrupted_ = solver_->Interrupted();
+        std::vector<bool> implied(n_clues, true);
+        for (int i = 0; i < candidates.size(); ++i) {
+            if (!backbone[i]) implied[candidate_clue[i]] = false;
+        }
+        for (int i = 0; i < n_clues; ++i) {
+            if (status[i] == 0 && implied[i]) status[i] = -1;
+        }
+    };
+
+    if (solve_without(-1).size() > 0 || interrupted_) {
+        solver_->AddClause({!block});
+        cleanup();
+        return std::nullopt;
+    }
+    refine_by_core();
+    remove_implied();
+
+    int n_critical = 0, next_backbone_check = 1;
+    for (int i = 0; i < n_clues && !interrupted_; ++i) {
+        if (status[i] != 0) continue;
+        bool has_other_solution = solve_without(i).size() > 0;
+        if (interrupted_) {
+            break;
+        } else if (!has_other_solution) {
+            status[i] = -1;
+            refine_by_core();
+        } else {
+            status[i] = 1;
+            if (++n_critical == next_backbone_check) {
+                remove_implied();
+                next_backbone_check *= 2;
+            }
+        }
+    }
+    solver_->AddClause({!block});
+    cleanup();
+    if (interrupted_) {
+        return std::nullopt;
+    }
+
+    std::vector<std::pair<std::string, int>> ret;
+    for (int i = 0; i < n_clues; ++i) {
+        if (status[i] == 1) ret.push_back(clues[i]);
+    }
+    return ret;
+}
+std::vector<SATLit> IntegratedCSPSolver::ValueLiterals(const std::string& name, int value) {
+    if (HasBoolVar(name)) {
+        SATLit lit = mapping_->GetCode(conv_->ConvertBoolVar(GetBoolVar(name)));
+        return {value ? lit : !lit};
+    }
+    auto var = conv_->ConvertIntVar(GetIntVar(name));
+    return {mapping_->GetCodeLE(var, value), !mapping_->GetCodeLE(var, value - 1)};
+}
+int IntegratedCSPSolver::EnumerateParallel(const std::function<bool(const CSPAnswer&)>& callback, int max_solutions, int n_threads) {
+    if (!Prepare()) {
+        return 0;
+    }
+    if (!store_sat_clauses_ || n_threads <= 1) {
+        return Enumerate(callback, max_solutions);
+    }
+    if (max_solutions < 0) max_solutions = INT32_MAX;
+
+    // Cubes only on target literals keep the projected solutions of different cubes disjoint
+    auto cubes = SplitIntoCubes(*sat_, TargetSATVariables(), scopes_, n_threads * 8, true);
+
+    // Each cube is enumerated by a fresh solver, which makes its sequence of solutions reproducible
+    struct CubeResult {
+        std::vector<CSPAnswer> answers;
+        bool done = false;
+    };
+    std::vector<CubeResult> results(cubes.size());
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::atomic<int> next_cube(0);
+    std::atomic<bool> stop(false);
+
+    auto worker = [&]() {
+        while (!stop.load()) {
+            int c = next_cube++;
+            if (c >= cubes.size()) break;
+
+            Minisat::Solver solver;
+            while (solver.nVars() < sat_->NumVariables()) solver.newVar();
+            for (int i = 0; i < sat_->NumClauses(); ++i) AddClauseToMinisat(solver, sat_->GetClause(i));
+            for (int i = 0; i < sat_->NumConstraints(); ++i) solver.addConstraint(sat_->GetConstraint(i)->Emit());
+            Minisat::vec<Minisat::Lit> assumps;
+            for (SATLit lit : cubes[c]) {
+                if (lit != SAT::True()) assumps.push(Minisat::mkLit(lit.GetVariable(), lit.IsNegative()));
+            }
+
+            std::vector<CSPAnswer> answers;
+            while (!stop.load() && answers.size() < max_solutions && solver.solve(assumps)) {
+                answers.push_back(DecodeAnswer(ExtractMinisatModel(solver, sat_->NumVariables())));
+                AddClauseToMinisat(solver, BlockingClause(answers.back()));
+            }
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                results[c].answers = std::move(answers);
+                results[c].done = true;
+            }
+            cv.notify_all();
+        }
+    };
+    std::vector<std::thread> threads;
+    for (int i = 0; i < n_threads; ++i) {
+        threads.emplace_back(worker);
+    }
+
+    int n_solutions = 0;
+    for (int c = 0; c < cubes.size() && !stop.load(); ++c) {
+        std::vector<CSPAnswer> answers;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait(lock, [&]() { return results[c].done; });
+            answers = std::move(results[c].answers);
+        }
+        for (auto& answer : answers) {
+            ++n_solutions;
+            if (!callback(answer) || n_solutions == max_solutions) {
+                stop.store(true);
+                break;
+            }
+        }
+    }
+    stop.store(true);
+    for (auto& t : threads) t.join();
+    return n_solutions;
+}
+CountResult IntegratedCSPSolver::CountSolutions(int enumeration_limit) {
+    auto start = std::chrono::steady_clock::now();
+    auto elapsed = [&]() {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    };
+    if (!Prepare()) {
+        return CountResult{0, true, elapsed()};
+    }
+
+    // The counter works on the stored clauses; without it, the enumeration goes on to the end
+    bool use_counter = store_sat_clauses_ && sat_->NumConstraints() == 0;
+    uint64_t limit = std::max(enumeration_limit, 0);
+
+    // Blocking clauses are conditioned on `guard`, which is disabled once the enumeration ends
+    SATLit guard = solver_->NewVariable();
+    uint64_t n_enumerated = 0;
+    bool exceeded = false;
+    while (true) {
+        auto model = SolvePrepared({guard});
+        if (model.size() == 0) break;
+        if (use_counter && n_enumerated == limit) {
+            exceeded = true;
+            break;
+        }
+        ++n_enumerated;
+        std::vector<SATLit> clause = BlockingClause(DecodeAnswer(model));
+        clause.push_back(!guard);
+        solver_->AddClause(clause);
+    }
+    solver_->AddClause({!guard});
+    if (!exceeded) {
+        return CountResult{n_enumerated, true, elapsed()};
+    }
+
+    ProjectedCounter counter(*sat_, TargetSATVariables());
+    return CountResult{counter.Count(scopes_).value(), false, elapsed()};
+}
+std::vector<int> IntegratedCSPSolver::TargetSATVariables() {
+    const AnswerLayout& layout = GetAnswerLayout();
+    std::vector<int> ret;
+    for (auto& var : layout.bool_vars) {
+        ret.push_back(mapping_->GetVariable(var));
+    }
+    for (auto& var : layout.int_vars) {
+        int offset = mapping_->GetOffset(var), size = mapping_->GetDomain(var).size();
+        for (int i = 0; i < size - 1; ++i) ret.push_back(offset + i);
+    }
+    return ret;
+}
+std::vector<SATLit> IntegratedCSPSolver::BlockingClause(const CSPAnswer& answer) {
+    const AnswerLayout& layout = GetAnswerLayout();
+    const std::vector<int>& values = answer.Values();
+    int n_bool = layout.bool_vars.size();
+
+    std::vector<SATLit> ret;
+    for (int i = 0; i < n_bool; ++i) {
+        SATLit lit = mapping_->GetCode(layout.bool_vars[i]);
+        ret.push_back(values[i] ? !lit : lit);
+    }
+    for (int i = 0; i < layout.int_vars.size(); ++i) {
+        // x != v  <=>  (x <= v-1) || !(x <= v)
+        int v = values[n_bool + i];
+        SATLit below = mapping_->GetCodeLE(layout.int_vars[i], v - 1);
+        SATLit above = !mapping_->GetCodeLE(layout.int_vars[i], v);
+        if (below != SAT::False()) ret.push_back(below);
+        if (above != SAT::False()) ret.push_back(above);
+    }
+    return ret;
+}
+const IntegratedCSPSolver::AnswerLayout& IntegratedCSPSolver::GetAnswerLayout() {
+    if (answer_layout_.has_value()) {
+        return answer_layout_.value();
+    }
+
+    std::vector<std::string> bool_names, int_names;
     if (target_vars_.has_value()) {
-        const std::vector<std::string>& target_vars = target_vars_.value();
-        for (auto& v : target_vars) {
+        for (auto& v : target_vars_.value()) {
             if (HasBoolVar(v)) {
-                bool_ans[v] = mapping_->Retrieve(conv_->ConvertBoolVar(GetBoolVar(v)), answer_raw);
+                bool_names.push_back(v);
             } else if (HasIntVar(v)) {
-                int_ans[v] = mapping_->Retrieve(conv_->ConvertIntVar(GetIntVar(v)), answer_raw);
+                int_names.push_back(v);
             } else {
                 abort(); // TODO
             }
         }
     } else {
-        for (auto& v : bool_var_map_) {
-            bool_ans[v.first] = mapping_->Retrieve(conv_->ConvertBoolVar(v.second), answer_raw);
+        bool_names = BoolVars();
+        int_names = IntVars();
+    }
+
+    AnswerLayout layout;
+    layout.index = std::make_shared<CSPAnswerIndex>();
+    for (auto& v : bool_names) {
+        layout.index->position[v] = layout.index->names.size();
+        layout.index->names.push_back(v);
+        layout.bool_vars.push_back(conv_->ConvertBoolVar(GetBoolVar(v)));
+    }
+    for (auto& v : int_names) {
+        layout.index->position[v] = layout.index->names.size();
+        layout.index->names.push_back(v);
+        layout.int_vars.push_back(conv_->ConvertIntVar(GetIntVar(v)));
+    }
+    answer_layout_ = std::move(layout);
+    return answer_layout_.value();
+}
+CSPAnswer IntegratedCSPSolver::DecodeAnswer(const std::vector<bool>& assignment) {
+    const AnswerLayout& layout = GetAnswerLayout();
+    std::vector<int> values(layout.bool_vars.size() + layout.int_vars.size());
+    mapping_->RetrieveAll(layout.bool_vars, assignment, values.data());
+    mapping_->RetrieveAll(layout.int_vars, assignment, values.data() + layout.bool_vars.size());
+    return CSPAnswer(layout.index, std::move(values));
+}
+bool IntegratedCSPSolver::ExportDIMACS(std::ostream& cnf, std::ostream& layout) {
+    if (!icsp_) {
+        store_sat_clauses_ = true;
+    } else if (!store_sat_clauses_) {
+        return false;
+    }
+    if (!Prepare()) {
+        sat_->AddClause({});
+    }
+    WriteDIMACS(*sat_, cnf);
+    GetMappingLayout().Write(layout);
+    return true;
+}
+bool IntegratedCSPSolver::ExportWCNF(std::ostream& wcnf, std::ostream& layout) {
+    if (!icsp_) {
+        store_sat_clauses_ = true;
+    } else if (!store_sat_clauses_) {
+        return false;
+    }
+    std::vector<std::pair<std::vector<SATLit>, long long>> soft_clauses;
+    if (!Prepare()) {
+        sat_->AddClause({});
+    } else {
+        for (auto& soft : soft_constraints_) {
+            soft_clauses.push_back({{!mapping_->GetCode(conv_->ConvertBoolVar(soft.first))}, soft.second});
         }
-        for (auto& v : int_var_map_) {
-            int_ans[v.first] = mapping_->Retrieve(conv_->ConvertIntVar(v.second), answer_raw);
+    }
+    WriteWCNF(*sat_, soft_clauses, wcnf);
+    GetMappingLayout().Write(layout);
+    return true;
+}
+MappingLayout IntegratedCSPSolver::GetMappingLayout() const {
+    MappingLayout ret;
+    if (!mapping_) return ret;
+    auto add_var = [&](const std::string& name) {
+        if (HasBoolVar(name)) {
+            ret.AddBool(name, mapping_->GetVariable(conv_->ConvertBoolVar(GetBoolVar(name))));
+        } else if (HasIntVar(name)) {
+            auto var = conv_->ConvertIntVar(GetIntVar(name));
+            ret.AddInt(name, mapping_->GetDomain(var), mapping_->GetOffset(var));
         }
+    };
+    if (target_vars_.has_value()) {
+        for (auto& v : target_vars_.value()) add_var(v);
+    } else {
+        for (auto& v : bool_var_map_) add_var(v.first);
+        for (auto& v : int_var_map_) add_var(v.first);
     }
-
-    return CSPAnswer(std::move(bool_ans), std::move(int_ans));
+    return ret;
 }
 }
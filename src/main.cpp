@@ -3,7 +3,9 @@
 #include <utility>
 #include <vector>
 #include <cstdlib>
+#include <cstring>
 #include <map>
+#include <set>
 #include <sstream>
 
 #include "integrated/integrated.h"
@@ -28,10 +30,12 @@ bool IsComment(const std::string& s) {
     return s.size() >= 1 && s[0] == ';';
 }
 
-void InputCSP(IntegratedCSPSolver& solver, bool& has_answer_key, std::vector<std::string>& answer_keys, int& max_answers) {
+void InputCSP(IntegratedCSPSolver& solver, bool& has_answer_key, std::vector<std::string>& answer_keys, int& max_answers, bool& print_stats, int& report_size) {
     std::string line;
+    int line_number = 0;
 
     while (std::getline(std::cin, line)) {
+        ++line_number;
         if (line.size() == 0 || IsComment(line)) {
             continue;
         } else if (line[0] == '#') {
@@ -40,117 +44,79 @@ void InputCSP(IntegratedCSPSolver& solver, bool& has_answer_key, std::vector<std
             has_answer_key = true;
 		} else if (line[0] == '$') {
 			max_answers = std::stoi(line.substr(1));
+        } else if (line[0] == '%') {
+            auto toks = Tokenize(line.substr(1));
+            if (toks.size() == 1 && toks[0] == "stats") print_stats = true;
+            if (toks.size() == 2 && toks[0] == "report") report_size = std::stoi(toks[1]);
         } else if (line[0] == '?') {
             break;
         } else {
-            solver.Parse(line);
+            solver.Parse(line, line_number);
         }
     }
 }
 
 void SolveLocalMaximal(IntegratedCSPSolver& solver,
     std::vector<std::string>& answer_keys) {
-    CSPAnswer answer = solver.Solve();
+    for (auto& name : answer_keys) {
+        if (!solver.HasBoolVar(name)) {
+            std::cout << "bool variable " << name << " not found" << std::endl;
+            return;
+        }
+    }
     solver.SetTargetVars(answer_keys);
+    CSPAnswer answer = solver.SolveMaximal();
 
     if (!answer.IsSat()) {
         std::cout << "unsat" << std::endl;
         return;
     }
 
-    std::map<std::string, bool> not_refuted_bool;
+    std::set<std::string> not_true;
     for (auto& name : answer_keys) {
-        if (solver.HasBoolVar(name)) {
-            not_refuted_bool.insert({ name, answer.GetBool(name) });
-        }
-        else {
-            std::cout << "bool variable " << name << " not found" << std::endl;
-            return;
-        }
-    }
-    while (true) {
-        std::vector<std::shared_ptr<Expr>> refuting_exprs;
-        for (auto it = not_refuted_bool.begin(); it != not_refuted_bool.end(); ) {
-            if (answer.GetBool(it->first) == true) {
-                solver.AddConstraint(Expr::VarBool(solver.GetBoolVar(it->first)));
-                it = not_refuted_bool.erase(it);
-            }
-            else {
-                refuting_exprs.push_back(Expr::VarBool(solver.GetBoolVar(it->first)));
-                ++it;
-            }
-        }
-        if (not_refuted_bool.empty()) break;
-        solver.AddConstraint(std::make_shared<Expr>(kOr, refuting_exprs));
-        answer = solver.Solve();
-        if (!answer.IsSat()) break;
+        if (!answer.GetBool(name)) not_true.insert(name);
     }
     std::cout << "sat" << std::endl;
-    for (auto& p : not_refuted_bool) {
-        std::cout << p.first << ' ' << (p.second ? "true" : "false") << std::endl;
+    for (auto& name : not_true) {
+        std::cout << name << " false" << std::endl;
     }
 }
 
 void SolveIrrefutably(IntegratedCSPSolver& solver,
                       std::vector<std::string>& answer_keys) {
-    CSPAnswer answer = solver.Solve();
+    for (auto& name : answer_keys) {
+        if (!solver.HasBoolVar(name) && !solver.HasIntVar(name)) {
+            std::cout << "variable " << name << " not found" << std::endl;
+            return;
+        }
+    }
     solver.SetTargetVars(answer_keys);
+    CSPAnswer answer = solver.SolveIrrefutably();
 
     if (!answer.IsSat()) {
         std::cout << "unsat" << std::endl;
         return;
     }
 
-    std::map<std::string, bool> not_refuted_bool;
-    std::map<std::string, int> not_refuted_int;
-    for (auto& name : answer_keys) {
+    std::map<std::string, bool> fixed_bool;
+    std::map<std::string, int> fixed_int;
+    for (auto& name : answer.Names()) {
         if (solver.HasBoolVar(name)) {
-            not_refuted_bool.insert({name, answer.GetBool(name)});
-        } else if (solver.HasIntVar(name)) {
-            not_refuted_int.insert({name, answer.GetInt(name)});
+            fixed_bool.insert({name, answer.GetBool(name)});
         } else {
-            std::cout << "variable " << name << " not found" << std::endl;
-            return;
-        }
-    }
-    while (true) {
-        std::vector<std::shared_ptr<Expr>> refuting_exprs;
-        for (auto& p : not_refuted_bool) {
-            refuting_exprs.push_back(Expr::Make(kXor, {Expr::VarBool(solver.GetBoolVar(p.first)), Expr::ConstBool(p.second)}));
-        }
-        for (auto& p : not_refuted_int) {
-            refuting_exprs.push_back(Expr::Make(kNe, {Expr::VarInt(solver.GetIntVar(p.first)), Expr::ConstInt(p.second)}));
-        }
-        solver.AddConstraint(std::make_shared<Expr>(kOr, refuting_exprs));
-        
-        answer = solver.Solve();
-        if (!answer.IsSat()) break;
-    
-        for (auto it = not_refuted_bool.begin(); it != not_refuted_bool.end(); ) {
-            if (answer.GetBool(it->first) != it->second) {
-                it = not_refuted_bool.erase(it);
-            } else {
-                ++it;
-            }
-        }
-        for (auto it = not_refuted_int.begin(); it != not_refuted_int.end(); ) {
-            if (answer.GetInt(it->first) != it->second) {
-                it = not_refuted_int.erase(it);
-            } else {
-                ++it;
-            }
+            fixed_int.insert({name, answer.GetInt(name)});
         }
     }
     std::cout << "sat" << std::endl;
-    for (auto& p : not_refuted_bool) {
+    for (auto& p : fixed_bool) {
         std::cout << p.first << ' ' << (p.second ? "true" : "false") << std::endl;
     }
-    for (auto& p : not_refuted_int) {
+    for (auto& p : fixed_int) {
         std::cout << p.first << ' ' << p.second << std::endl;
     }
 }
 
-void OutputAnswer(IntegratedCSPSolver& solver, std::vector<std::string>& answer_keys, CSPAnswer& answer) {
+void OutputAnswer(IntegratedCSPSolver& solver, std::vector<std::string>& answer_keys, const CSPAnswer& answer) {
 
 	for (auto& name : answer_keys) {
 		if (solver.HasBoolVar(name)) {
@@ -171,51 +137,49 @@ void FindAllSolutions(IntegratedCSPSolver& solver,
 	std::vector<std::string>& answer_keys,
 	int max_solutions
 	) {
-	CSPAnswer answer = solver.Solve();
-	solver.SetTargetVars(answer_keys);
-	if (max_solutions == -1)
-		max_solutions = INT32_MAX;
-	if (!answer.IsSat()) {
-		std::cout << "unsat" << std::endl;
-		return;
-	}
-	std::cout << "ans 0" << std::endl;
-	OutputAnswer(solver, answer_keys, answer);
-	std::set<std::string> not_refuted_bool;
-	std::set<std::string> not_refuted_int;
 	for (auto& name : answer_keys) {
-		if (solver.HasBoolVar(name)) {
-			not_refuted_bool.insert(name);
-		}
-		else if (solver.HasIntVar(name)) {
-			not_refuted_int.insert(name);
-		}
-		else {
+		if (!solver.HasBoolVar(name) && !solver.HasIntVar(name)) {
 			std::cout << "variable " << name << " not found" << std::endl;
 			return;
 		}
 	}
-	for (int i = 1; i < max_solutions; ++i) {
-		std::vector<std::shared_ptr<Expr>> refuting_exprs;
-		for (auto& p : not_refuted_bool) {
-			refuting_exprs.push_back(Expr::Make(kXor, { Expr::VarBool(solver.GetBoolVar(p)), Expr::ConstBool(answer.GetBool(p)) }));
-		}
-		for (auto& p : not_refuted_int) {
-			refuting_exprs.push_back(Expr::Make(kNe, { Expr::VarInt(solver.GetIntVar(p)), Expr::ConstInt(answer.GetInt(p)) }));
-		}
-		solver.AddConstraint(std::make_shared<Expr>(kOr, refuting_exprs));
-
-		answer = solver.Solve();
-		if (!answer.IsSat()) break;
+	solver.SetTargetVars(answer_keys);
+	if (max_solutions == -1)
+		max_solutions = INT32_MAX;
 
-		std::cout << "ans " << i << std::endl;
+	int n_answers = 0;
+	solver.Enumerate([&](const CSPAnswer& answer) {
+		std::cout << "ans " << n_answers++ << std::endl;
 		OutputAnswer(solver, answer_keys, answer);
-	}
+		return true;
+	}, max_solutions);
 	std::cout << "unsat" << std::endl;
 }
 
+void CountSolutions(IntegratedCSPSolver& solver,
+    std::vector<std::string>& answer_keys) {
+    for (auto& name : answer_keys) {
+        if (!solver.HasBoolVar(name) && !solver.HasIntVar(name)) {
+            std::cout << "variable " << name << " not found" << std::endl;
+            return;
+        }
+    }
+    if (answer_keys.size() > 0) solver.SetTargetVars(answer_keys);
+    // the projected model counter works on the stored clauses
+    solver.SetStoreSATClauses(true);
+    CountResult result = solver.CountSolutions();
+    std::cout << "count " << result.count << std::endl;
+    std::cout << "time " << result.seconds << std::endl;
+}
+
 void FindAnswer(IntegratedCSPSolver& solver) {
-    CSPAnswer answer = solver.Solve();
+    if (solver.HasSoftConstraints() && solver.HasObjective()) {
+        std::cout << "soft constraints cannot be combined with minimize/maximize" << std::endl;
+        return;
+    }
+    CSPAnswer answer = solver.HasSoftConstraints() ? solver.SolveMaxSAT()
+                     : solver.HasObjective() ? solver.Optimize()
+                     : solver.Solve();
 
     if (!answer.IsSat()) {
         std::cout << "s UNSATISFIABLE" << std::endl;
@@ -223,6 +187,9 @@ void FindAnswer(IntegratedCSPSolver& solver) {
     }
 
     std::cout << "s SATISFIABLE" << std::endl;
+    if (answer.HasObjective()) {
+        std::cout << "o " << answer.GetObjective() << std::endl;
+    }
     auto bool_vars = solver.BoolVars();
     for (auto& var : bool_vars) {
         std::cout << "a " << var << '\t' << (answer.GetBool(var) ? "true" : "false") << std::endl;
@@ -234,14 +201,60 @@ void FindAnswer(IntegratedCSPSolver& solver) {
     std::cout << "a" << std::endl;
 }
 
+void OutputStats(const CSPStats& stats) {
+    std::cout << "c convert_time " << stats.convert_seconds << std::endl;
+    std::cout << "c propagate_time " << stats.propagate_seconds << std::endl;
+    std::cout << "c simplify_time " << stats.simplify_seconds << std::endl;
+    std::cout << "c encode_time " << stats.encode_seconds << std::endl;
+    std::cout << "c solve_time " << stats.solve_seconds << std::endl;
+    std::cout << "c icsp_bool_vars " << stats.icsp_bool_vars << std::endl;
+    std::cout << "c icsp_int_vars " << stats.icsp_int_vars << std::endl;
+    std::cout << "c icsp_clauses " << stats.icsp_clauses << std::endl;
+    std::cout << "c sat_vars " << stats.sat_vars << std::endl;
+    std::cout << "c sat_clauses " << stats.sat_clauses << std::endl;
+    std::cout << "c sat_constraints " << stats.sat_constraints << std::endl;
+    std::cout << "c conflicts " << stats.conflicts << std::endl;
+    std::cout << "c decisions " << stats.decisions << std::endl;
+    std::cout << "c propagations " << stats.propagations << std::endl;
+    for (int i = 0; i < stats.constraint_profiles.size(); ++i) {
+        auto& p = stats.constraint_profiles[i];
+        std::cout << "c constraint " << i
+                  << " propagate_calls " << p.propagate_calls << " propagate_time " << p.propagate_seconds
+                  << " propagations " << p.propagations << " conflicts " << p.conflicts
+                  << " reasons " << p.calc_reason_calls << " reason_time " << p.calc_reason_seconds
+                  << " avg_reason_length " << p.AverageReasonLength() << std::endl;
+    }
+}
+
+void OutputEncodingReport(IntegratedCSPSolver& solver, int report_size) {
+    for (auto& r : solver.EncodingReport(report_size)) {
+        std::cout << "c line " << r.line
+                  << " sat_clauses " << r.sat_clauses << " sat_constraints " << r.sat_constraints << " sat_vars " << r.sat_vars
+                  << " icsp_clauses " << r.icsp_clauses
+                  << " literals " << r.bool_literals << '/' << r.linear_literals << '/' << r.graph_literals
+                  << " aux_vars " << r.aux_bool_vars << '/' << r.aux_int_vars << " splits";
+        for (int threshold : r.split_thresholds) {
+            if (threshold == EncodingChoice::kDirect) std::cout << " direct";
+            else std::cout << ' ' << threshold;
+        }
+        std::cout << std::endl;
+        std::cout << "c   " << r.text << std::endl;
+    }
+}
+
 int main() {
     bool has_answer_key = false;
 	int max_answers = 0;
+    bool print_stats = false;
+    int report_size = 0;
     std::vector<std::string> answer_keys;
     IntegratedCSPSolver solver;
-    InputCSP(solver, has_answer_key, answer_keys, max_answers);
+    InputCSP(solver, has_answer_key, answer_keys, max_answers, print_stats, report_size);
+    solver.SetProfileTiming(print_stats);
     if (max_answers == -2) {
         SolveLocalMaximal(solver, answer_keys);
+    } else if (max_answers == -3) {
+        CountSolutions(solver, answer_keys);
     } else if (max_answers != 0) {
 		FindAllSolutions(solver, answer_keys, max_answers);
 	} else if (has_answer_key) {
@@ -249,12 +262,22 @@ int main() {
 	} else {
         FindAnswer(solver);
     }
+    if (print_stats) {
+        OutputStats(solver.GetStats());
+    }
+    if (report_size > 0) {
+        OutputEncodingReport(solver, report_size);
+    }
 
     return 0;
 }
 char* lib_buffer = NULL;
 
+#ifdef _WIN32
 extern "C" __declspec(dllexport) char* __cdecl Call(const char* query) {
+#else
+extern "C" char* Call(const char* query) {
+#endif
     std::istringstream stream(query);
     std::cin.rdbuf(stream.rdbuf());
     std::ostringstream out;
@@ -36,59 +36,30 @@ public:
             answer_key_vec.push_back(answer_keys[i].as<std::string>());
         }
 
+        for (auto& name : answer_key_vec) {
+            if (!solver_.HasBoolVar(name) && !solver_.HasIntVar(name)) {
+                // unknown names are reported only for satisfiable problems
+                val ret = val::object();
+                bool is_sat = solver_.Solve().IsSat();
+                ret.set("is_sat", is_sat);
+                if (is_sat) ret.set("error", true);
+                return ret;
+            }
+        }
         solver_.SetTargetVars(answer_key_vec);
-        CSPAnswer answer = solver_.Solve();
+        CSPAnswer answer = solver_.SolveIrrefutably();
 
         val ret = val::object();
         ret.set("is_sat", answer.IsSat());
         if (!answer.IsSat()) return ret;
 
-        std::map<std::string, bool> not_refuted_bool;
-        std::map<std::string, int> not_refuted_int;
-        for (auto& name : answer_key_vec) {
+        for (auto& name : answer.Names()) {
             if (solver_.HasBoolVar(name)) {
-                not_refuted_bool.insert({name, answer.GetBool(name)});
-            } else if (solver_.HasIntVar(name)) {
-                not_refuted_int.insert({name, answer.GetInt(name)});
+                ret.set(name, val(answer.GetBool(name)));
             } else {
-                ret.set("error", true);
-                return ret;
+                ret.set(name, val(answer.GetInt(name)));
             }
         }
-        while (true) {
-            std::vector<std::shared_ptr<Expr>> refuting_exprs;
-            for (auto& p : not_refuted_bool) {
-                refuting_exprs.push_back(Expr::Make(kXor, {Expr::VarBool(solver_.GetBoolVar(p.first)), Expr::ConstBool(p.second)}));
-            }
-            for (auto& p : not_refuted_int) {
-                refuting_exprs.push_back(Expr::Make(kNe, {Expr::VarInt(solver_.GetIntVar(p.first)), Expr::ConstInt(p.second)}));
-            }
-            solver_.AddConstraint(std::make_shared<Expr>(kOr, refuting_exprs));
-            
-            answer = solver_.Solve();
-            if (!answer.IsSat()) break;
-        
-            for (auto it = not_refuted_bool.begin(); it != not_refuted_bool.end(); ) {
-                if (answer.GetBool(it->first) != it->second) {
-                    it = not_refuted_bool.erase(it);
-                } else {
-                    ++it;
-                }
-            }
-            for (auto it = not_refuted_int.begin(); it != not_refuted_int.end(); ) {
-                if (answer.GetInt(it->first) != it->second) {
-                    it = not_refuted_int.erase(it);
-                } else {
-                    ++it;
-                }
-            }
-        }
-        for (auto& p : not_refuted_bool) {
-            ret.set(p.first, val(p.second));
-        }
-        for (auto& p : not_refuted_int) {
-            ret.set(p.first, val(p.second));
-        }
         return ret;
     }
 
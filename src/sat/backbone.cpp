@@ -0,0 +1,84 @@
+#include "sat/backbone.h"
+
+#include <algorithm>
+
+namespace csugar {
+
+namespace {
+
+bool IsTrue(const std::vector<bool>& model, SATLit lit) {
+    return model[lit.GetVariable()] != lit.IsNegative();
+}
+
+}
+
+std::vector<bool> ComputeBackbone(Solver& solver, const std::vector<SATLit>& candidates, const std::vector<bool>& model,
+                                  const std::vector<SATLit>& assumptions) {
+    const int kInitialChunkSize = 8;
+    const int kMaxChunkSize = 256;
+
+    std::vector<bool> ret(candidates.size(), false);
+
+    // indices of candidates which are neither refuted nor proved yet
+    std::vector<int> pending;
+    for (int i = 0; i < candidates.size(); ++i) {
+        SATLit lit = candidates[i];
+        if (lit.GetVariable() == 0) {
+            ret[i] = (lit == SAT::True());
+        } else if (IsTrue(model, lit)) {
+            pending.push_back(i);
+        }
+    }
+
+    auto add_backbone = [&](SATLit lit) {
+        std::vector<SATLit> clause{lit};
+        for (SATLit a : assumptions) clause.push_back(!a);
+        solver.AddClause(clause);
+    };
+
+    int chunk_size = kInitialChunkSize;
+    while (!pending.empty()) {
+        int n = std::min(chunk_size, (int)pending.size());
+        std::vector<bool> refuting_model;
+
+        if (n == 1) {
+            std::vector<SATLit> assumps = assumptions;
+            assumps.push_back(!candidates[pending.back()]);
+            refuting_model = solver.SolveUnder(assumps);
+        } else {
+            // (act -> some literal in the chunk is false); `act` is disabled permanently afterwards
+            SATLit act = solver.NewVariable();
+            std::vector<SATLit> clause{!act};
+            for (int i = 0; i < n; ++i) {
+                clause.push_back(!candidates[pending[pending.size() - 1 - i]]);
+            }
+            solver.AddClause(clause);
+
+            std::vector<SATLit> assumps = assumptions;
+            assumps.push_back(act);
+            refuting_model = solver.SolveUnder(assumps);
+            solver.AddClause({!act});
+        }
+
+        if (refuting_model.empty() && solver.Interrupted()) {
+            break;
+        } else if (refuting_model.empty()) {
+            for (int i = 0; i < n; ++i) {
+                int idx = pending.back();
+                pending.pop_back();
+                ret[idx] = true;
+                add_backbone(candidates[idx]);
+            }
+            chunk_size = std::min(chunk_size * 2, kMaxChunkSize);
+        } else {
+            pending.erase(std::remove_if(pending.begin(), pending.end(), [&](int idx) {
+                return !IsTrue(refuting_model, candidates[idx]);
+            }), pending.end());
+            chunk_size = std::max(chunk_size / 2, 1);
+        }
+    }
+
+    return ret;
+}
+
+}
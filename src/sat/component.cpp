@@ -0,0 +1,122 @@
+#include "sat/component.h"
+
+#include <algorithm>
+#include <atomic>
+#include <numeric>
+#include <thread>
+
+#include "sat/solver.h"
+
+namespace csugar {
+
+ComponentSolver::ComponentSolver(const SAT& sat, const std::vector<int>& var_component, int n_components, int n_threads) :
+    sat_(sat), var_group_(sat.NumVariables(), -1), n_threads_(n_threads) {
+    auto owner = [&](const std::vector<SATLit>& lits) {
+        for (SATLit lit : lits) {
+            int v = lit.GetVariable();
+            if (v < var_component.size() && var_component[v] != -1) return var_component[v];
+        }
+        return -1;
+    };
+
+    // Pack the components into groups, largest first into the lightest group
+    std::vector<long long> sizes(n_components, 0);
+    for (int i = 0; i < sat.NumClauses(); ++i) {
+        int c = owner(sat.GetClause(i));
+        if (c != -1) sizes[c] += sat.GetClause(i).size();
+    }
+    for (int i = 0; i < sat.NumConstraints(); ++i) {
+        int c = owner(sat.GetConstraint(i)->Literals());
+        if (c != -1) sizes[c] += sat.GetConstraint(i)->Literals().size();
+    }
+    int n_groups = std::max(1, std::min(n_components, 4 * n_threads));
+    std::vector<int> order(n_components), component_group(n_components);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return sizes[a] > sizes[b]; });
+    group_sizes_.assign(n_groups, 0);
+    for (int c : order) {
+        int g = std::min_element(group_sizes_.begin(), group_sizes_.end()) - group_sizes_.begin();
+        component_group[c] = g;
+        group_sizes_[g] += sizes[c] + 1;
+    }
+    for (int v = 0; v < var_component.size() && v < sat.NumVariables(); ++v) {
+        if (var_component[v] != -1) var_group_[v] = component_group[var_component[v]];
+    }
+
+    std::vector<std::vector<bool>> used(n_groups, std::vector<bool>(sat.NumVariables(), false));
+    for (int g = 0; g < n_groups; ++g) {
+        solvers_.push_back(std::make_unique<Minisat::Solver>());
+        while (solvers_[g]->nVars() < sat.NumVariables()) solvers_[g]->newVar();
+    }
+    for (int i = 0; i < sat.NumClauses(); ++i) {
+        const std::vector<SATLit>& clause = sat.GetClause(i);
+        int c = owner(clause);
+        // a clause only on shared variables has to be respected by every group
+        for (int g = 0; g < n_groups; ++g) {
+            if (c != -1 && component_group[c] != g) continue;
+            AddClauseToMinisat(*solvers_[g], clause);
+            for (SATLit lit : clause) used[g][lit.GetVariable()] = true;
+        }
+    }
+    for (int i = 0; i < sat.NumConstraints(); ++i) {
+        auto& constraint = sat.GetConstraint(i);
+        std::vector<SATLit> lits = constraint->Literals();
+        int c = owner(lits);
+        int g = c == -1 ? 0 : component_group[c];
+        solvers_[g]->addConstraint(constraint->Emit());
+        for (SATLit lit : lits) used[g][lit.GetVariable()] = true;
+    }
+
+    // Variables of the other groups are left out of the search
+    for (int g = 0; g < n_groups; ++g) {
+        for (int v = 0; v < sat.NumVariables(); ++v) {
+            if (!used[g][v]) solvers_[g]->setDecisionVar(v, false);
+        }
+    }
+}
+std::vector<bool> ComponentSolver::Solve(const std::vector<SATLit>& assumptions) {
+    int n_groups = solvers_.size();
+    std::vector<int> order(n_groups);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return group_sizes_[a] > group_sizes_[b]; });
+
+    Minisat::vec<Minisat::Lit> assumps;
+    for (SATLit lit : assumptions) {
+        if (lit != SAT::True()) assumps.push(Minisat::mkLit(lit.GetVariable(), lit.IsNegative()));
+    }
+    for (auto& solver : solvers_) solver->clearInterrupt();
+
+    std::atomic<int> next(0);
+    std::atomic<bool> unsat(false);
+    auto worker = [&]() {
+        while (!unsat.load()) {
+            int i = next++;
+            if (i >= n_groups) break;
+            if (!solvers_[order[i]]->solve(assumps)) {
+                // no need to finish the other groups
+                unsat.store(true);
+                for (auto& solver : solvers_) solver->interrupt();
+                break;
+            }
+        }
+    };
+    std::vector<std::thread> threads;
+    for (int i = 0; i < std::min(n_threads_, n_groups); ++i) {
+        threads.emplace_back(worker);
+    }
+    for (auto& t : threads) t.join();
+    if (unsat.load()) {
+        return std::vector<bool>();
+    }
+
+    std::vector<bool> ret(sat_.NumVariables(), false);
+    ret[0] = true;
+    Minisat::lbool ltrue((uint8_t)0);
+    for (int v = 1; v < sat_.NumVariables(); ++v) {
+        int g = var_group_[v];
+        if (g != -1) ret[v] = (solvers_[g]->model[v] == ltrue);
+    }
+    return ret;
+}
+
+}
@@ -0,0 +1,234 @@
+#include "sat/counter.h"
+
+#include <algorithm>
+#include <numeric>
+
+#include "sat/solver.h"
+
+namespace csugar {
+
+namespace {
+
+// Literals are encoded as 2 * var + (negative ? 1 : 0)
+int EncodeLit(SATLit lit) {
+    return lit.GetVariable() * 2 + (lit.IsNegative() ? 1 : 0);
+}
+
+uint64_t SaturatingAdd(uint64_t a, uint64_t b) {
+    return a > UINT64_MAX - b ? UINT64_MAX : a + b;
+}
+uint64_t SaturatingMul(uint64_t a, uint64_t b) {
+    if (a == 0 || b == 0) return 0;
+    return a > UINT64_MAX / b ? UINT64_MAX : a * b;
+}
+
+}
+
+ProjectedCounter::ProjectedCounter(const SAT& sat, const std::vector<int>& projection) :
+    occurs_(sat.NumVariables() * 2), is_projection_(sat.NumVariables(), false), value_(sat.NumVariables(), -1),
+    qhead_(0), root_size_(0), ok_(true), supported_(sat.NumConstraints() == 0), parent_(sat.NumVariables(), -1), slot_(sat.NumVariables(), -1),
+    n_decisions_(0), n_cache_hits_(0) {
+    // components cannot see through non-clause constraints
+    if (!supported_) return;
+    for (int var : projection) is_projection_[var] = true;
+
+    while (solver_.nVars() < sat.NumVariables()) solver_.newVar();
+    std::vector<int> units;
+    for (int i = 0; i < sat.NumClauses(); ++i) {
+        AddClauseToMinisat(solver_, sat.GetClause(i));
+
+        std::vector<int> c;
+        for (SATLit lit : sat.GetClause(i)) c.push_back(EncodeLit(lit));
+        std::sort(c.begin(), c.end());
+        c.erase(std::unique(c.begin(), c.end()), c.end());
+        bool tautology = false;
+        for (int j = 1; j < c.size(); ++j) {
+            if (c[j] == (c[j - 1] ^ 1)) tautology = true;
+        }
+        if (tautology) continue;
+
+        if (c.size() == 0) ok_ = false;
+        if (c.size() == 1) units.push_back(c[0]);
+        for (int lit : c) occurs_[lit].push_back(clauses_.size());
+        clauses_.push_back(std::move(c));
+    }
+    for (int lit : units) {
+        if (!ok_) break;
+        if (!Assume(lit)) ok_ = false;
+    }
+    root_size_ = trail_.size();
+}
+std::optional<uint64_t> ProjectedCounter::Count(const std::vector<SATLit>& assumptions) {
+    if (!supported_) return std::nullopt;
+    if (!ok_) return 0;
+
+    uint64_t ret = 0;
+    bool consistent = true;
+    for (SATLit lit : assumptions) {
+        if (lit == SAT::True()) continue;
+        decisions_.push(Minisat::mkLit(lit.GetVariable(), lit.IsNegative()));
+        if (!Assume(EncodeLit(lit))) {
+            consistent = false;
+            break;
+        }
+    }
+    if (consistent && Satisfiable()) {
+        std::vector<int> vars(value_.size()), clauses(clauses_.size());
+        std::iota(vars.begin(), vars.end(), 0);
+        std::iota(clauses.begin(), clauses.end(), 0);
+        ret = CountSplit(vars, clauses);
+    }
+    decisions_.clear();
+    Backtrack(root_size_);
+    return ret;
+}
+bool ProjectedCounter::Assume(int lit) {
+    int v = Value(lit);
+    if (v == 0) return false;
+    if (v == 1) return true;
+    value_[lit >> 1] = (lit & 1) ? 0 : 1;
+    trail_.push_back(lit);
+    return Propagate();
+}
+bool ProjectedCounter::Propagate() {
+    while (qhead_ < trail_.size()) {
+        int p = trail_[qhead_++] ^ 1;  // literal which became false
+        for (int ci : occurs_[p]) {
+            int unit = -1, n_unassigned = 0;
+            bool satisfied = false;
+            for (int lit : clauses_[ci]) {
+                int v = Value(lit);
+                if (v == 1) {
+                    satisfied = true;
+                    break;
+                }
+                if (v == -1) {
+                    unit = lit;
+                    ++n_unassigned;
+                }
+            }
+            if (satisfied || n_unassigned >= 2) continue;
+            if (n_unassigned == 0) {
+                qhead_ = trail_.size();
+                return false;
+            }
+            value_[unit >> 1] = (unit & 1) ? 0 : 1;
+            trail_.push_back(unit);
+        }
+    }
+    return true;
+}
+void ProjectedCounter::Backtrack(int size) {
+    while (trail_.size() > size) {
+        value_[trail_.back() >> 1] = -1;
+        trail_.pop_back();
+    }
+    qhead_ = std::min(qhead_, size);
+}
+bool ProjectedCounter::Satisfiable() {
+    // Once the whole formula is satisfiable under the decisions, so is each of its components.
+    // Thus a component without projection variables counts as exactly one.
+    return solver_.solve(decisions_);
+}
+int ProjectedCounter::FindRoot(int var) {
+    while (parent_[var] != var) {
+        parent_[var] = parent_[parent_[var]];
+        var = parent_[var];
+    }
+    return var;
+}
+uint64_t ProjectedCounter::CountSplit(const std::vector<int>& vars, const std::vector<int>& clauses) {
+    std::vector<int> open, touched;
+    for (int ci : clauses) {
+        auto& c = clauses_[ci];
+        if (std::any_of(c.begin(), c.end(), [&](int lit) { return Value(lit) == 1; })) continue;
+        open.push_back(ci);
+        int root = -1;
+        for (int lit : c) {
+            int var = lit >> 1;
+            if (value_[var] != -1) continue;
+            if (parent_[var] == -1) {
+                parent_[var] = var;
+                touched.push_back(var);
+            }
+            int r = FindRoot(var);
+            if (root == -1) root = r;
+            else if (r != root) parent_[r] = root;
+        }
+    }
+
+    uint64_t ret = 1;
+    for (int var : vars) {
+        if (value_[var] == -1 && is_projection_[var] && parent_[var] == -1) ret = SaturatingMul(ret, 2);
+    }
+
+    std::vector<Component> components;
+    for (int var : touched) {
+        int r = FindRoot(var);
+        if (slot_[r] == -1) {
+            slot_[r] = components.size();
+            components.emplace_back();
+        }
+        components[slot_[r]].vars.push_back(var);
+    }
+    for (int ci : open) {
+        for (int lit : clauses_[ci]) {
+            if (value_[lit >> 1] == -1) {
+                components[slot_[FindRoot(lit >> 1)]].clauses.push_back(ci);
+                break;
+            }
+        }
+    }
+    for (int var : touched) slot_[FindRoot(var)] = -1;
+    for (int var : touched) parent_[var] = -1;
+
+    for (auto& component : components) {
+        if (ret == 0) break;
+        std::sort(component.vars.begin(), component.vars.end());
+        ret = SaturatingMul(ret, CountComponent(component));
+    }
+    return ret;
+}
+uint64_t ProjectedCounter::CountComponent(const Component& component) {
+    const size_t kMaxCacheEntries = 1 << 20;
+
+    int branch = -1;
+    size_t best_occurrences = 0;
+    for (int var : component.vars) {
+        if (!is_projection_[var]) continue;
+        size_t occurrences = occurs_[var * 2].size() + occurs_[var * 2 + 1].size();
+        if (branch == -1 || occurrences > best_occurrences) {
+            branch = var;
+            best_occurrences = occurrences;
+        }
+    }
+    if (branch == -1) return 1;
+
+    // The residual clauses are exactly the component's clauses restricted to its variables
+    std::vector<int> key = component.vars;
+    key.push_back(-1);
+    key.insert(key.end(), component.clauses.begin(), component.clauses.end());
+    auto it = cache_.find(key);
+    if (it != cache_.end()) {
+        ++n_cache_hits_;
+        return it->second;
+    }
+
+    uint64_t total = 0;
+    for (int lit : {branch * 2, branch * 2 + 1}) {
+        ++n_decisions_;
+        int base = trail_.size();
+        decisions_.push(Minisat::mkLit(branch, (lit & 1) != 0));
+        if (Assume(lit) && Satisfiable()) {
+            total = SaturatingAdd(total, CountSplit(component.vars, component.clauses));
+        }
+        decisions_.pop();
+        Backtrack(base);
+    }
+
+    if (cache_.size() >= kMaxCacheEntries) cache_.clear();
+    cache_.emplace(std::move(key), total);
+    return total;
+}
+
+}
@@ -0,0 +1,349 @@
+#include "sat/cube.h"
+
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#include "sat/solver.h"
+
+namespace csugar {
+
+namespace {
+
+// Literals are encoded as 2 * var + (negative ? 1 : 0)
+int EncodeLit(SATLit lit) {
+    return lit.GetVariable() * 2 + (lit.IsNegative() ? 1 : 0);
+}
+SATLit DecodeLit(int x) {
+    return SATLit(x >> 1, (x & 1) != 0);
+}
+
+// Unit propagation with two watched literals over the clauses of a SAT, with backtracking to any trail size
+class Propagator {
+public:
+    explicit Propagator(const SAT& sat) : value_(sat.NumVariables(), -1), watches_(sat.NumVariables() * 2), qhead_(0), ok_(true) {
+        for (int i = 0; i < sat.NumClauses(); ++i) {
+            std::vector<int> c;
+            for (SATLit lit : sat.GetClause(i)) c.push_back(EncodeLit(lit));
+            std::sort(c.begin(), c.end());
+            c.erase(std::unique(c.begin(), c.end()), c.end());
+            bool tautology = false;
+            for (int j = 1; j < c.size(); ++j) {
+                if (c[j] == (c[j - 1] ^ 1)) tautology = true;
+            }
+            if (tautology) continue;
+
+            if (c.size() == 0) {
+                ok_ = false;
+            } else if (c.size() == 1) {
+                units_.push_back(c[0]);
+            } else {
+                watches_[c[0]].push_back(clauses_.size());
+                watches_[c[1]].push_back(clauses_.size());
+                clauses_.push_back(std::move(c));
+            }
+        }
+        for (int lit : units_) {
+            if (!ok_) break;
+            if (!Assume(lit)) ok_ = false;
+        }
+    }
+
+    bool ok() const { return ok_; }
+    int NumVariables() const { return value_.size(); }
+    // 1: true, 0: false, -1: unassigned
+    int Value(int lit) const {
+        int v = value_[lit >> 1];
+        return v < 0 ? -1 : (v ^ (lit & 1));
+    }
+    int TrailSize() const { return trail_.size(); }
+
+    // Assigns `lit` and propagates; returns false on conflict (the caller is expected to backtrack)
+    bool Assume(int lit) {
+        int v = Value(lit);
+        if (v == 0) return false;
+        if (v == 1) return true;
+        Enqueue(lit);
+        return Propagate();
+    }
+    void Backtrack(int size) {
+        while (trail_.size() > size) {
+            value_[trail_.back() >> 1] = -1;
+            trail_.pop_back();
+        }
+        qhead_ = std::min(qhead_, size);
+    }
+
+private:
+    void Enqueue(int lit) {
+        value_[lit >> 1] = (lit & 1) ? 0 : 1;
+        trail_.push_back(lit);
+    }
+    bool Propagate() {
+        while (qhead_ < trail_.size()) {
+            int p = trail_[qhead_++] ^ 1;  // literal which became false
+            std::vector<int>& ws = watches_[p];
+            int j = 0;
+            for (int i = 0; i < ws.size(); ++i) {
+                std::vector<int>& c = clauses_[ws[i]];
+                if (c[0] == p) std::swap(c[0], c[1]);
+                if (Value(c[0]) == 1) {
+                    ws[j++] = ws[i];
+                    continue;
+                }
+                bool moved = false;
+                for (int k = 2; k < c.size(); ++k) {
+                    if (Value(c[k]) != 0) {
+                        std::swap(c[1], c[k]);
+                        watches_[c[1]].push_back(ws[i]);
+                        moved = true;
+                        break;
+                    }
+                }
+                if (moved) continue;
+                ws[j++] = ws[i];
+                if (Value(c[0]) == 0) {
+                    for (++i; i < ws.size(); ++i) ws[j++] = ws[i];
+                    ws.resize(j);
+                    qhead_ = trail_.size();
+                    return false;
+                }
+                Enqueue(c[0]);
+            }
+            ws.resize(j);
+        }
+        return true;
+    }
+
+    std::vector<std::vector<int>> clauses_;
+    std::vector<int> units_;
+    std::vector<signed char> value_;
+    std::vector<std::vector<int>> watches_;
+    std::vector<int> trail_;
+    int qhead_;
+    bool ok_;
+};
+
+class Splitter {
+public:
+    Splitter(Propagator& prop, const std::vector<int>& candidates) : prop_(prop), candidates_(candidates) {}
+
+    void Split(std::vector<int>& cube, int depth, std::vector<std::vector<int>>& out) {
+        const int kMaxEvaluated = 32;
+
+        int trail_begin = prop_.TrailSize();
+        int cube_begin = cube.size();
+        int best_var = -1;
+        while (true) {
+            best_var = -1;
+            long long best_score = -1;
+            bool failed = false;
+            int n_evaluated = 0;
+            for (int var : candidates_) {
+                if (n_evaluated >= kMaxEvaluated) break;
+                if (prop_.Value(var * 2) != -1) continue;
+                ++n_evaluated;
+
+                int base = prop_.TrailSize();
+                bool pos_ok = prop_.Assume(var * 2);
+                long long pos_implied = prop_.TrailSize() - base;
+                prop_.Backtrack(base);
+                bool neg_ok = prop_.Assume(var * 2 + 1);
+                long long neg_implied = prop_.TrailSize() - base;
+                prop_.Backtrack(base);
+
+                if (!pos_ok && !neg_ok) {
+                    // this node has no solution
+                    Restore(cube, cube_begin, trail_begin);
+                    return;
+                }
+                if (!pos_ok || !neg_ok) {
+                    // failed literal: the other polarity is implied
+                    int lit = pos_ok ? var * 2 : var * 2 + 1;
+                    prop_.Assume(lit);
+                    cube.push_back(lit);
+                    failed = true;
+                    break;
+                }
+                long long score = (pos_implied + 1) * (neg_implied + 1);
+                if (score > best_score) {
+                    best_score = score;
+                    best_var = var;
+                }
+            }
+            if (!failed) break;
+        }
+
+        if (depth == 0 || best_var == -1) {
+            out.push_back(cube);
+        } else {
+            for (int lit : {best_var * 2, best_var * 2 + 1}) {
+                int base = prop_.TrailSize();
+                if (prop_.Assume(lit)) {
+                    cube.push_back(lit);
+                    Split(cube, depth - 1, out);
+                    cube.pop_back();
+                }
+                prop_.Backtrack(base);
+            }
+        }
+        Restore(cube, cube_begin, trail_begin);
+    }
+
+private:
+    void Restore(std::vector<int>& cube, int cube_size, int trail_size) {
+        cube.resize(cube_size);
+        prop_.Backtrack(trail_size);
+    }
+
+    Propagator& prop_;
+    const std::vector<int>& candidates_;
+};
+
+}
+
+std::vector<std::vector<SATLit>> SplitIntoCubes(const SAT& sat, const std::vector<int>& preferred_vars,
+                                                const std::vector<SATLit>& assumptions, int max_cubes, bool preferred_only) {
+    Propagator prop(sat);
+    if (!prop.ok()) return {};
+
+    std::vector<int> cube;
+    for (SATLit lit : assumptions) {
+        if (!prop.Assume(EncodeLit(lit))) return {};
+        cube.push_back(EncodeLit(lit));
+    }
+
+    // Branching candidates: preferred variables first, each group by decreasing number of occurrences
+    std::vector<int> occurrences(sat.NumVariables(), 0);
+    for (int i = 0; i < sat.NumClauses(); ++i) {
+        for (SATLit lit : sat.GetClause(i)) ++occurrences[lit.GetVariable()];
+    }
+    std::vector<bool> is_preferred(sat.NumVariables(), false);
+    for (int v : preferred_vars) is_preferred[v] = true;
+    std::vector<int> candidates;
+    for (int v = 1; v < sat.NumVariables(); ++v) {
+        if (occurrences[v] > 0 && (is_preferred[v] || !preferred_only)) candidates.push_back(v);
+    }
+    std::stable_sort(candidates.begin(), candidates.end(), [&](int a, int b) {
+        if (is_preferred[a] != is_preferred[b]) return (bool)is_preferred[a];
+        return occurrences[a] > occurrences[b];
+    });
+
+    int depth = 0;
+    while ((2 << depth) <= max_cubes) ++depth;
+
+    std::vector<std::vector<int>> cubes_raw;
+    Splitter(prop, candidates).Split(cube, depth, cubes_raw);
+
+    std::vector<std::vector<SATLit>> ret;
+    for (auto& c : cubes_raw) {
+        std::vector<SATLit> lits;
+        for (int x : c) lits.push_back(DecodeLit(x));
+        ret.push_back(std::move(lits));
+    }
+    return ret;
+}
+
+CubeAndConquerSolver::CubeAndConquerSolver(const SAT& sat, int n_threads) :
+    sat_(sat), n_threads_(n_threads), max_cubes_(n_threads * 8), loaded_clauses_(0), loaded_constraints_(0) {
+    for (int i = 0; i < n_threads; ++i) {
+        workers_.push_back(std::make_unique<Minisat::Solver>());
+    }
+}
+void CubeAndConquerSolver::LoadPending() {
+    for (auto& worker : workers_) {
+        while (worker->nVars() < sat_.NumVariables()) {
+            worker->newVar();
+        }
+        for (int i = loaded_clauses_; i < sat_.NumClauses(); ++i) {
+            AddClauseToMinisat(*worker, sat_.GetClause(i));
+        }
+        for (int i = loaded_constraints_; i < sat_.NumConstraints(); ++i) {
+            worker->addConstraint(sat_.GetConstraint(i)->Emit());
+        }
+    }
+    loaded_clauses_ = sat_.NumClauses();
+    loaded_constraints_ = sat_.NumConstraints();
+}
+std::vector<bool> CubeAndConquerSolver::Solve(const std::vector<SATLit>& assumptions) {
+    LoadPending();
+    auto cubes = SplitIntoCubes(sat_, preferred_vars_, assumptions, max_cubes_);
+
+    // Cubes are dealt round-robin; an idle worker takes from the back of its own queue
+    // and steals from the front of the others'
+    struct CubeQueue {
+        std::mutex mutex;
+        std::deque<int> cubes;
+    };
+    std::vector<CubeQueue> queues(n_threads_);
+    for (int i = 0; i < cubes.size(); ++i) {
+        queues[i % n_threads_].cubes.push_back(i);
+    }
+    auto take_cube = [&](int self) {
+        {
+            std::lock_guard<std::mutex> lock(queues[self].mutex);
+            if (!queues[self].cubes.empty()) {
+                int ret = queues[self].cubes.back();
+                queues[self].cubes.pop_back();
+                return ret;
+            }
+        }
+        for (int i = 1; i < n_threads_; ++i) {
+            CubeQueue& victim = queues[(self + i) % n_threads_];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.cubes.empty()) {
+                int ret = victim.cubes.front();
+                victim.cubes.pop_front();
+                return ret;
+            }
+        }
+        return -1;
+    };
+
+    for (auto& worker : workers_) {
+        worker->clearInterrupt();
+        worker->budgetOff();
+    }
+    std::atomic<bool> finished(false);
+    std::atomic<int> winner(-1);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < n_threads_; ++i) {
+        threads.emplace_back([&, i]() {
+            Minisat::Solver& worker = *workers_[i];
+            while (!finished.load()) {
+                int cube = take_cube(i);
+                if (cube < 0) break;
+                Minisat::vec<Minisat::Lit> assumps;
+                for (SATLit lit : cubes[cube]) {
+                    if (lit == SAT::True()) continue;
+                    assumps.push(Minisat::mkLit(lit.GetVariable(), lit.IsNegative()));
+                }
+                Minisat::lbool res = worker.solveLimited(assumps);
+                if (res == l_True) {
+                    int expected = -1;
+                    if (winner.compare_exchange_strong(expected, i)) {
+                        finished.store(true);
+                        for (int j = 0; j < n_threads_; ++j) {
+                            if (j != i) workers_[j]->interrupt();
+                        }
+                    }
+                    break;
+                } else if (res == l_Undef) {
+                    break;
+                }
+            }
+        });
+    }
+    for (auto& t : threads) t.join();
+
+    int w = winner.load();
+    if (w < 0) {
+        // every cube is unsatisfiable
+        return std::vector<bool>();
+    }
+    return ExtractMinisatModel(*workers_[w], sat_.NumVariables());
+}
+
+}
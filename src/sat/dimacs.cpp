@@ -0,0 +1,277 @@
+#include "sat/dimacs.h"
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <iterator>
+
+namespace csugar {
+
+namespace {
+
+class BufferedWriter {
+public:
+    BufferedWriter(std::ostream& out) : out_(out), pos_(0) {}
+    ~BufferedWriter() { Flush(); }
+
+    void PutChar(char c) {
+        if (pos_ == kBufferSize) Flush();
+        buf_[pos_++] = c;
+    }
+    void PutString(const std::string& s) {
+        for (char c : s) PutChar(c);
+    }
+    void PutInt(long long v) {
+        if (pos_ + 24 > kBufferSize) Flush();
+        if (v < 0) {
+            buf_[pos_++] = '-';
+            v = -v;
+        }
+        char tmp[24];
+        int n = 0;
+        do {
+            tmp[n++] = '0' + (v % 10);
+            v /= 10;
+        } while (v > 0);
+        while (n > 0) buf_[pos_++] = tmp[--n];
+    }
+    void PutLit(SATLit lit) {
+        PutInt(lit.IsNegative() ? -(lit.GetVariable() + 1) : (lit.GetVariable() + 1));
+    }
+    void Flush() {
+        out_.write(buf_, pos_);
+        pos_ = 0;
+    }
+
+private:
+    static constexpr int kBufferSize = 1 << 16;
+
+    std::ostream& out_;
+    char buf_[kBufferSize];
+    int pos_;
+};
+
+void WriteClauseBody(BufferedWriter& writer, const std::vector<SATLit>& clause) {
+    for (SATLit lit : clause) {
+        writer.PutLit(lit);
+        writer.PutChar(' ');
+    }
+    writer.PutChar('0');
+    writer.PutChar('\n');
+}
+
+void WriteConstraintComment(BufferedWriter& writer, const SAT& sat) {
+    if (sat.NumConstraints() > 0) {
+        writer.PutString("c warning: ");
+        writer.PutInt(sat.NumConstraints());
+        writer.PutString(" non-clause constraints are not included\n");
+    }
+}
+
+class Scanner {
+public:
+    Scanner(std::istream& in) : data_(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()), pos_(0) {}
+
+    bool AtEnd() const { return pos_ >= data_.size(); }
+    char Peek() const { return data_[pos_]; }
+    void SkipLine() {
+        while (!AtEnd() && data_[pos_] != '\n') ++pos_;
+    }
+    void SkipSpaces() {
+        while (!AtEnd() && (data_[pos_] == ' ' || data_[pos_] == '\t' || data_[pos_] == '\n' || data_[pos_] == '\r')) ++pos_;
+    }
+    std::string NextWord() {
+        SkipSpaces();
+        std::string ret;
+        while (!AtEnd() && !(data_[pos_] == ' ' || data_[pos_] == '\t' || data_[pos_] == '\n' || data_[pos_] == '\r')) {
+            ret.push_back(data_[pos_++]);
+        }
+        return ret;
+    }
+    bool NextInt(long long& v) {
+        SkipSpaces();
+        bool negative = false;
+        if (!AtEnd() && data_[pos_] == '-') {
+            negative = true;
+            ++pos_;
+        }
+        if (AtEnd() || !('0' <= data_[pos_] && data_[pos_] <= '9')) return false;
+        v = 0;
+        while (!AtEnd() && '0' <= data_[pos_] && data_[pos_] <= '9') {
+            v = v * 10 + (data_[pos_++] - '0');
+        }
+        if (negative) v = -v;
+        return true;
+    }
+
+private:
+    std::string data_;
+    size_t pos_;
+};
+
+}
+
+void WriteDIMACS(const SAT& sat, std::ostream& out) {
+    BufferedWriter writer(out);
+    WriteConstraintComment(writer, sat);
+    writer.PutString("p cnf ");
+    writer.PutInt(sat.NumVariables());
+    writer.PutChar(' ');
+    writer.PutInt(sat.NumClauses());
+    writer.PutChar('\n');
+    for (int i = 0; i < sat.NumClauses(); ++i) {
+        WriteClauseBody(writer, sat.GetClause(i));
+    }
+}
+void WriteWCNF(const SAT& sat, const std::vector<std::pair<std::vector<SATLit>, long long>>& soft_clauses, std::ostream& out) {
+    long long top = 1;
+    for (auto& c : soft_clauses) top += c.second;
+
+    BufferedWriter writer(out);
+    WriteConstraintComment(writer, sat);
+    writer.PutString("p wcnf ");
+    writer.PutInt(sat.NumVariables());
+    writer.PutChar(' ');
+    writer.PutInt(sat.NumClauses() + (long long)soft_clauses.size());
+    writer.PutChar(' ');
+    writer.PutInt(top);
+    writer.PutChar('\n');
+    for (int i = 0; i < sat.NumClauses(); ++i) {
+        writer.PutInt(top);
+        writer.PutChar(' ');
+        WriteClauseBody(writer, sat.GetClause(i));
+    }
+    for (auto& c : soft_clauses) {
+        writer.PutInt(c.second);
+        writer.PutChar(' ');
+        WriteClauseBody(writer, c.first);
+    }
+}
+bool ReadDIMACS(std::istream& in, SAT& sat) {
+    Scanner scanner(in);
+    long long n_vars = -1, n_clauses = -1;
+
+    while (true) {
+        scanner.SkipSpaces();
+        if (scanner.AtEnd()) return false;
+        if (scanner.Peek() == 'c') {
+            scanner.SkipLine();
+        } else if (scanner.Peek() == 'p') {
+            scanner.NextWord();
+            if (scanner.NextWord() != "cnf") return false;
+            if (!scanner.NextInt(n_vars) || !scanner.NextInt(n_clauses)) return false;
+            break;
+        } else {
+            return false;
+        }
+    }
+    if (n_vars < 1) return false;
+    sat.AddVariables(n_vars - sat.NumVariables());
+
+    std::vector<SATLit> clause;
+    for (long long i = 0; i < n_clauses; ++i) {
+        clause.clear();
+        while (true) {
+            long long v;
+            if (!scanner.NextInt(v)) return false;
+            if (v == 0) break;
+            if (v > n_vars || v < -n_vars) return false;
+            clause.push_back(SATLit((v > 0 ? v : -v) - 1, v < 0));
+        }
+        if (i == 0 && clause.size() == 1 && clause[0] == SAT::True()) {
+            // the constant-true clause is already in `sat`
+            continue;
+        }
+        sat.AddClause(clause);
+    }
+    return true;
+}
+std::vector<bool> ReadDIMACSModel(std::istream& in, int n_variables) {
+    std::vector<bool> ret(n_variables, false);
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.size() == 0 || line[0] != 'v') continue;
+        std::istringstream line_stream(line.substr(1));
+        long long v;
+        while (line_stream >> v) {
+            if (v == 0) break;
+            long long id = (v > 0 ? v : -v) - 1;
+            if (id < n_variables) ret[id] = (v > 0);
+        }
+    }
+    return ret;
+}
+std::vector<std::string> MappingLayout::BoolVars() const {
+    std::vector<std::string> ret;
+    for (auto& v : bool_vars_) ret.push_back(v.first);
+    return ret;
+}
+std::vector<std::string> MappingLayout::IntVars() const {
+    std::vector<std::string> ret;
+    for (auto& v : int_vars_) ret.push_back(v.first);
+    return ret;
+}
+bool MappingLayout::RetrieveBool(const std::string& name, const std::vector<bool>& assignment) const {
+    return assignment[bool_vars_.at(name)];
+}
+int MappingLayout::RetrieveInt(const std::string& name, const std::vector<bool>& assignment) const {
+    auto& info = int_vars_.at(name);
+    for (int i = 0; i < (int)info.first.size() - 1; ++i) {
+        if (assignment[info.second + i]) {
+            return info.first[i];
+        }
+    }
+    return info.first.back();
+}
+void MappingLayout::Write(std::ostream& out) const {
+    BufferedWriter writer(out);
+    for (auto& v : bool_vars_) {
+        writer.PutString("b ");
+        writer.PutString(v.first);
+        writer.PutChar(' ');
+        writer.PutInt(v.second + 1);
+        writer.PutChar('\n');
+    }
+    for (auto& v : int_vars_) {
+        writer.PutString("i ");
+        writer.PutString(v.first);
+        writer.PutChar(' ');
+        writer.PutInt(v.second.second + 1);
+        writer.PutChar(' ');
+        writer.PutInt(v.second.first.size());
+        for (int x : v.second.first) {
+            writer.PutChar(' ');
+            writer.PutInt(x);
+        }
+        writer.PutChar('\n');
+    }
+}
+bool MappingLayout::Read(std::istream& in) {
+    Scanner scanner(in);
+    while (true) {
+        std::string kind = scanner.NextWord();
+        if (kind.empty()) break;
+        std::string name = scanner.NextWord();
+        if (kind == "b") {
+            long long var;
+            if (!scanner.NextInt(var)) return false;
+            AddBool(name, var - 1);
+        } else if (kind == "i") {
+            long long offset, size;
+            if (!scanner.NextInt(offset) || !scanner.NextInt(size) || size <= 0) return false;
+            std::vector<int> domain;
+            for (long long i = 0; i < size; ++i) {
+                long long x;
+                if (!scanner.NextInt(x)) return false;
+                domain.push_back(x);
+            }
+            AddInt(name, domain, offset - 1);
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+}
@@ -82,14 +82,20 @@ namespace Minisat {
 
 ActiveVerticesConnected::ActiveVerticesConnected(const std::vector<Lit>& lits, const std::vector<std::pair<int, int>>& edges)
     : lits_(lits), adj_(lits.size()), state_(lits.size(), kUndecided), conflict_cause_pos_(-2), n_active_vertices_(0),
-      rank_(lits.size()), lowlink_(lits.size()), subtree_active_count_(lits.size()), cluster_id_(lits.size()), parent_(lits.size()) {
+      rank_(lits.size()), lowlink_(lits.size()), subtree_active_count_(lits.size()), cluster_id_(lits.size()), parent_(lits.size()),
+      analysis_valid_(false), incremental_(true), in_cluster_(lits.size(), false), is_articulation_(lits.size(), false) {
     for (auto& e : edges) {
         adj_[e.first].push_back(e.second);
         adj_[e.second].push_back(e.first);
     }
+    for (int i = 0; i < lits.size(); ++i) {
+        var_vertices_.push_back({var(lits[i]), i});
+        all_vertices_.push_back(i);
+    }
+    std::sort(var_vertices_.begin(), var_vertices_.end());
 }
 
-bool ActiveVerticesConnected::initialize(Solver& solver, vec<Lit>& out_watchers) {
+bool ActiveVerticesConnected::initializeImpl(Solver& solver, vec<Lit>& out_watchers) {
     for (int i = 0; i < lits_.size(); ++i) {
         lbool val = solver.value(lits_[i]);
         if (val != l_Undef) decision_order_.push_back(i);
@@ -119,35 +125,60 @@ bool ActiveVerticesConnected::initialize(Solver& solver, vec<Lit>& out_watchers)
     return true;
 }
 
-bool ActiveVerticesConnected::propagate(Solver& solver, Lit p) {
-    int n = lits_.size();
+bool ActiveVerticesConnected::propagateImpl(Solver& solver, Lit p) {
     solver.registerUndo(var(p), this);
-    for (int i = 0; i < n; ++i) {
-        if (var(lits_[i]) == var(p)) {
-            lbool val = solver.value(lits_[i]);
-            NodeState s;
-            if (val == l_True) {
-                s = kActive;
-                ++n_active_vertices_;
-            } else if (val == l_False) s = kInactive;
-            else abort();
-            state_[i] = s;
-            decision_order_.push_back(i);
-        }
+    if (!incremental_) analysis_valid_ = false;
+    bool unchanged = analysis_valid_;
+    auto range = std::equal_range(var_vertices_.begin(), var_vertices_.end(), std::make_pair(var(p), -1),
+                                  [](const std::pair<Var, int>& x, const std::pair<Var, int>& y) { return x.first < y.first; });
+    for (auto it = range.first; it != range.second; ++it) {
+        int i = it->second;
+        lbool val = solver.value(lits_[i]);
+        NodeState s;
+        if (val == l_True) {
+            s = kActive;
+            ++n_active_vertices_;
+            if (!is_articulation_[i]) unchanged = false;
+        } else if (val == l_False) {
+            s = kInactive;
+            if (in_cluster_[i]) unchanged = false;
+        } else abort();
+        state_[i] = s;
+        decision_order_.push_back(i);
     }
 
-    if (n_active_vertices_ == 0) return true;
+    // An articulation point was already known to be active, and vertices outside the active cluster
+    // were already enqueued to be inactive: neither changes the clusters or the articulation points.
+    if (unchanged) return true;
+
+    if (n_active_vertices_ == 0) {
+        analysis_valid_ = false;
+        return true;
+    }
+    if (analysis_valid_) {
+        // Everything outside the active cluster is already inactive, so only the cluster needs a new look
+        previous_cluster_.swap(cluster_vertices_);
+        return analyze(solver, previous_cluster_);
+    }
+    return analyze(solver, all_vertices_);
+}
 
-    std::fill(rank_.begin(), rank_.end(), kUnvisited);
-    std::fill(lowlink_.begin(), lowlink_.end(), kUndecided);
-    std::fill(subtree_active_count_.begin(), subtree_active_count_.end(), 0);
-    std::fill(cluster_id_.begin(), cluster_id_.end(), kUndecided);
-    std::fill(parent_.begin(), parent_.end(), -1);
+bool ActiveVerticesConnected::analyze(Solver& solver, const std::vector<int>& vertices) {
+    analysis_valid_ = false;
+    for (int v : vertices) {
+        rank_[v] = kUnvisited;
+        lowlink_[v] = kUndecided;
+        subtree_active_count_[v] = 0;
+        cluster_id_[v] = kUndecided;
+        parent_[v] = -1;
+        in_cluster_[v] = false;
+        is_articulation_[v] = false;
+    }
     next_rank_ = 0;
 
     int nonempty_cluster = -1, n_all_clusters = 0;
 
-    for (int i = 0; i < n; ++i) {
+    for (int i : vertices) {
         if (state_[i] != kInactive && rank_[i] == kUnvisited) {
             buildTree(i, -1, i);
             int sz = subtree_active_count_[i];
@@ -163,10 +194,22 @@ bool ActiveVerticesConnected::propagate(Solver& solver, Lit p) {
         }
     }
 
-    if (n_active_vertices_ <= 1 && n_all_clusters <= 1) return true;
+    cluster_vertices_.clear();
+    for (int v : vertices) {
+        if (state_[v] != kInactive && cluster_id_[v] == nonempty_cluster) {
+            in_cluster_[v] = true;
+            cluster_vertices_.push_back(v);
+        }
+    }
+
+    if (n_active_vertices_ <= 1 && n_all_clusters <= 1) {
+        // Nothing is enqueued here, which is complete only if there is no other cluster
+        analysis_valid_ = (n_all_clusters == 0);
+        return true;
+    }
 
     if (nonempty_cluster != -1) {
-        for (int v = 0; v < n; ++v) {
+        for (int v : vertices) {
             if (state_[v] != kUndecided) continue;
 
             if (cluster_id_[v] != nonempty_cluster) {
@@ -182,7 +225,7 @@ bool ActiveVerticesConnected::propagate(Solver& solver, Lit p) {
                 int parent_side_count = subtree_active_count_[nonempty_cluster] - subtree_active_count_[v];
                 int n_nonempty_subgraph = 0;
                 for (auto w : adj_[v]) {
-                    if (rank_[v] < rank_[w] && parent_[w] == v) {
+                    if (state_[w] != kInactive && rank_[v] < rank_[w] && parent_[w] == v) {
                         // `w` is a child of `v`
                         if (lowlink_[w] < rank_[v]) {
                             // `w` is not separated from `v`'s parent even after removal of `v`
@@ -195,6 +238,7 @@ bool ActiveVerticesConnected::propagate(Solver& solver, Lit p) {
                 if (parent_side_count > 0) ++n_nonempty_subgraph;
                 if (n_nonempty_subgraph >= 2) {
                     // `v` is an articulation point
+                    is_articulation_[v] = true;
                     if (!solver.enqueue(lits_[v], this)) {
                         conflict_cause_pos_ = v;
                         conflict_cause_lit_ = ~lits_[v];
@@ -204,6 +248,7 @@ bool ActiveVerticesConnected::propagate(Solver& solver, Lit p) {
             }
         }
     }
+    analysis_valid_ = true;
     return true;
 }
 
@@ -229,7 +274,7 @@ int ActiveVerticesConnected::buildTree(int v, int parent, int cluster_id) {
     return lowlink_[v] = lowlink;
 }
 
-void ActiveVerticesConnected::calcReason(Solver& solver, Lit p, vec<Lit>& out_reason) {
+void ActiveVerticesConnected::calcReasonImpl(Solver& solver, Lit p, vec<Lit>& out_reason) {
     if (p == lit_Undef && conflict_cause_pos_ == -2) abort();
     if (p == lit_Undef && conflict_cause_pos_ != -1) {
         decision_order_.push_back(conflict_cause_pos_);
@@ -287,13 +332,15 @@ void ActiveVerticesConnected::calcReason(Solver& solver, Lit p, vec<Lit>& out_re
     }
 }
 
-void ActiveVerticesConnected::undo(Solver& solver, Lit p) {
-    for (int i = 0; i < lits_.size(); ++i) {
-        if (var(lits_[i]) == var(p)) {
-            if (state_[i] == kActive) --n_active_vertices_;
-            state_[i] = kUndecided;
-            decision_order_.pop_back();
-        }
+void ActiveVerticesConnected::undoImpl(Solver& solver, Lit p) {
+    analysis_valid_ = false;
+    auto range = std::equal_range(var_vertices_.begin(), var_vertices_.end(), std::make_pair(var(p), -1),
+                                  [](const std::pair<Var, int>& x, const std::pair<Var, int>& y) { return x.first < y.first; });
+    for (auto it = range.first; it != range.second; ++it) {
+        int i = it->second;
+        if (state_[i] == kActive) --n_active_vertices_;
+        state_[i] = kUndecided;
+        decision_order_.pop_back();
     }
 }
 
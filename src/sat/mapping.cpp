@@ -5,15 +5,21 @@
 namespace csugar {
 
 void Mapping::RegisterMappingBool(std::shared_ptr<ICSPBoolVar> var) {
-    if (mapping_bool_.count(var) > 0) {
+    if (var->id() >= bool_code_.size()) {
+        bool_code_.resize(var->id() + 1, -1);
+    }
+    if (bool_code_[var->id()] != -1) {
         // TODO: error
     }
     int id = sat_.NumVariables();
     sat_.AddVariables(1);
-    mapping_bool_.insert({var, id});
+    bool_code_[var->id()] = id;
 }
 void Mapping::RegisterMappingInt(std::shared_ptr<ICSPIntVar> var) {
-    if (mapping_int_.count(var) > 0) {
+    if (var->id() >= int_info_.size()) {
+        int_info_.resize(var->id() + 1, IntVarInfo{-1, 0, 0});
+    }
+    if (int_info_[var->id()].offset != -1) {
         // TODO: error
     }
     int id = sat_.NumVariables();
@@ -21,31 +27,63 @@ void Mapping::RegisterMappingInt(std::shared_ptr<ICSPIntVar> var) {
     if (domain.size() == 0) {
         // TODO: error
     }
-    mapping_int_.insert({var, {domain, id }});
+    int_info_[var->id()] = IntVarInfo{id, (int)domain_values_.size(), (int)domain.size()};
+    domain_values_.insert(domain_values_.end(), domain.begin(), domain.end());
     sat_.AddVariables((int)domain.size() - 1);
 }
-bool Mapping::Retrieve(std::shared_ptr<ICSPBoolVar> var, const std::vector<bool> &assignment) {
-    int id = mapping_bool_.at(var);
-    return assignment[id];
+bool Mapping::Retrieve(std::shared_ptr<ICSPBoolVar> var, const std::vector<bool> &assignment) const {
+    return assignment[bool_code_[var->id()]];
+}
+int Mapping::Retrieve(std::shared_ptr<ICSPIntVar> var, const std::vector<bool> &assignment) const {
+    return DecodeInt(int_info_[var->id()], assignment);
 }
-int Mapping::Retrieve(std::shared_ptr<ICSPIntVar> var, const std::vector<bool> &assignment) {
-    auto& info = mapping_int_.at(var);
-    for (int i = 0; i < (int)info.first.size() - 1; ++i) {
-        if (assignment[info.second + i]) {
-            return info.first[i];
+void Mapping::RetrieveAll(const std::vector<std::shared_ptr<ICSPBoolVar>>& vars, const std::vector<bool> &assignment, int* out) const {
+    for (int i = 0; i < vars.size(); ++i) {
+        out[i] = assignment[bool_code_[vars[i]->id()]] ? 1 : 0;
+    }
+}
+void Mapping::RetrieveAll(const std::vector<std::shared_ptr<ICSPIntVar>>& vars, const std::vector<bool> &assignment, int* out) const {
+    for (int i = 0; i < vars.size(); ++i) {
+        out[i] = DecodeInt(int_info_[vars[i]->id()], assignment);
+    }
+}
+int Mapping::DecodeInt(const IntVarInfo& info, const std::vector<bool> &assignment) const {
+    // (var <= domain[i]) is monotone in i, so the value is at the first true bit
+    int lo = 0, hi = info.domain_size - 1;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (assignment[info.offset + mid]) hi = mid;
+        else lo = mid + 1;
+    }
+    return domain_values_[info.domain_begin + lo];
+}
+std::vector<int> Mapping::GetDomain(std::shared_ptr<ICSPIntVar> var) const {
+    auto& info = int_info_[var->id()];
+    return std::vector<int>(domain_values_.begin() + info.domain_begin, domain_values_.begin() + info.domain_begin + info.domain_size);
+}
+std::vector<int> Mapping::MappedVariables() const {
+    std::vector<int> ret;
+    for (int code : bool_code_) {
+        if (code != -1) ret.push_back(code);
+    }
+    for (auto& info : int_info_) {
+        if (info.offset == -1) continue;
+        for (int i = 0; i < info.domain_size - 1; ++i) {
+            ret.push_back(info.offset + i);
         }
     }
-    return info.first.back();
+    return ret;
 }
-SATLit Mapping::GetCodeLE(std::shared_ptr<ICSPIntVar> var, int c) {
-    auto& info = mapping_int_[var];
-    if (c < info.first[0]) {
+SATLit Mapping::GetCodeLE(std::shared_ptr<ICSPIntVar> var, int c) const {
+    auto& info = int_info_[var->id()];
+    const int* domain = domain_values_.data() + info.domain_begin;
+    if (c < domain[0]) {
         return sat_.False();
-    } else if (c >= info.first.back()) {
+    } else if (c >= domain[info.domain_size - 1]) {
         return sat_.True();
     }
-    int dist = std::distance(info.first.begin(), std::upper_bound(info.first.begin(), info.first.end(), c));
-    return SATLit(info.second + dist - 1);
+    int dist = std::distance(domain, std::upper_bound(domain, domain + info.domain_size, c));
+    return SATLit(info.offset + dist - 1);
 }
 
 }
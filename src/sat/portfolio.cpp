@@ -0,0 +1,189 @@
+#include "sat/portfolio.h"
+
+#include <algorithm>
+#include <thread>
+
+#include "sat/solver.h"
+
+namespace csugar {
+
+ClauseExchange::ClauseExchange() : slots_(new Slot[kCapacity]), head_(0) {
+    for (int i = 0; i < kCapacity; ++i) {
+        slots_[i].seq.store(0, std::memory_order_relaxed);
+    }
+}
+void ClauseExchange::Publish(const std::vector<int>& lits) {
+    if (lits.size() > kMaxClauseSize) return;
+    uint64_t n = head_.load(std::memory_order_relaxed);
+    Slot& slot = slots_[n % kCapacity];
+
+    slot.seq.store(2 * n + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.size.store(lits.size(), std::memory_order_relaxed);
+    for (int i = 0; i < lits.size(); ++i) {
+        slot.lits[i].store(lits[i], std::memory_order_relaxed);
+    }
+    slot.seq.store(2 * n + 2, std::memory_order_release);
+    head_.store(n + 1, std::memory_order_release);
+}
+void ClauseExchange::Fetch(uint64_t& cursor, std::vector<std::vector<int>>& out) const {
+    uint64_t head = head_.load(std::memory_order_acquire);
+    if (head - cursor > kCapacity) cursor = head - kCapacity;
+    for (; cursor < head; ++cursor) {
+        const Slot& slot = slots_[cursor % kCapacity];
+        uint64_t expected = 2 * cursor + 2;
+        if (slot.seq.load(std::memory_order_acquire) != expected) continue;
+
+        int size = slot.size.load(std::memory_order_relaxed);
+        if (size > kMaxClauseSize) continue;
+        std::vector<int> lits(size);
+        for (int i = 0; i < size; ++i) {
+            lits[i] = slot.lits[i].load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.seq.load(std::memory_order_relaxed) != expected) continue;
+        out.push_back(std::move(lits));
+    }
+}
+
+// MiniSat instance which can publish its short learnt clauses and import those of the others.
+// Exchange happens between rounds of solveLimited, when the solver is at decision level 0.
+class PortfolioSolver::Worker : public Minisat::Solver {
+public:
+    Worker(int index, int n_workers) : index_(index), cursors_(n_workers, 0), exported_learnts_(0), recent_(kRecentSize, 0) {
+        if (index > 0) {
+            random_seed = 91648253 + 7919.0 * index;
+            rnd_pol = (index % 2 == 1);
+            luby_restart = (index % 4 != 3);
+            restart_first = 100 << (index % 3);
+            random_var_freq = 0.01 * (index % 5);
+        }
+    }
+
+    Minisat::lbool Run(const Minisat::vec<Minisat::Lit>& assumps, const std::atomic<bool>& finished,
+                       std::vector<std::unique_ptr<ClauseExchange>>& exchanges) {
+        const int64_t kInitialBudget = 1000;
+
+        int64_t budget = kInitialBudget;
+        while (!finished.load(std::memory_order_relaxed)) {
+            Import(exchanges);
+            if (!okay()) return l_False;
+            setConfBudget(budget);
+            Minisat::lbool res = solveLimited(assumps);
+            if (res != l_Undef) return res;
+            Export(*exchanges[index_]);
+            budget = budget * 3 / 2;
+        }
+        return l_Undef;
+    }
+
+private:
+    static constexpr int kRecentSize = 1 << 14;
+
+    // Publishes the short learnt clauses added since the last call. reduceDB() and simplify() reorder
+    // and remove learnts in between, so a few new ones may be missed (or old ones seen again); that only
+    // affects how much is shared.
+    void Export(ClauseExchange& exchange) {
+        for (int i = std::min(exported_learnts_, learnts.size()); i < learnts.size(); ++i) {
+            const Minisat::Clause& c = ca[learnts[i]];
+            if (c.size() > ClauseExchange::kMaxClauseSize) continue;
+            std::vector<int> lits;
+            for (int j = 0; j < c.size(); ++j) lits.push_back(Minisat::toInt(c[j]));
+            std::sort(lits.begin(), lits.end());
+            if (Remember(lits)) {
+                exchange.Publish(lits);
+            }
+        }
+        exported_learnts_ = learnts.size();
+    }
+    void Import(std::vector<std::unique_ptr<ClauseExchange>>& exchanges) {
+        std::vector<std::vector<int>> clauses;
+        for (int i = 0; i < exchanges.size(); ++i) {
+            if (i != index_) exchanges[i]->Fetch(cursors_[i], clauses);
+        }
+        for (auto& lits : clauses) {
+            // imported clauses are not published again
+            Remember(lits);
+            Minisat::vec<Minisat::Lit> c;
+            for (int x : lits) c.push(Minisat::toLit(x));
+            if (!addClause_(c)) return;
+        }
+    }
+    // Records `lits` in a direct-mapped table of clause hashes; returns false if it was there already.
+    // The table has a fixed size, so a clause evicted by a colliding one may be published twice.
+    bool Remember(const std::vector<int>& lits) {
+        uint64_t h = 14695981039346656037ULL;
+        for (int x : lits) h = (h ^ static_cast<uint32_t>(x)) * 1099511628211ULL;
+        uint64_t& slot = recent_[h % kRecentSize];
+        if (slot == h) return false;
+        slot = h;
+        return true;
+    }
+
+    int index_;
+    std::vector<uint64_t> cursors_;
+    int exported_learnts_;  // size of `learnts` after the last Export
+    std::vector<uint64_t> recent_;
+};
+
+PortfolioSolver::PortfolioSolver(const SAT& sat, int n_workers) : sat_(sat), loaded_clauses_(0), loaded_constraints_(0) {
+    for (int i = 0; i < n_workers; ++i) {
+        workers_.push_back(std::make_unique<Worker>(i, n_workers));
+        exchanges_.push_back(std::make_unique<ClauseExchange>());
+    }
+}
+PortfolioSolver::~PortfolioSolver() {}
+
+void PortfolioSolver::LoadPending() {
+    for (auto& worker : workers_) {
+        while (worker->nVars() < sat_.NumVariables()) {
+            worker->newVar();
+        }
+        for (int i = loaded_clauses_; i < sat_.NumClauses(); ++i) {
+            AddClauseToMinisat(*worker, sat_.GetClause(i));
+        }
+        for (int i = loaded_constraints_; i < sat_.NumConstraints(); ++i) {
+            worker->addConstraint(sat_.GetConstraint(i)->Emit());
+        }
+    }
+    loaded_clauses_ = sat_.NumClauses();
+    loaded_constraints_ = sat_.NumConstraints();
+}
+std::vector<bool> PortfolioSolver::Solve(const std::vector<SATLit>& assumptions) {
+    LoadPending();
+
+    Minisat::vec<Minisat::Lit> assumps;
+    for (SATLit lit : assumptions) {
+        if (lit == SAT::True()) continue;
+        assumps.push(Minisat::mkLit(lit.GetVariable(), lit.IsNegative()));
+    }
+
+    std::atomic<bool> finished(false);
+    std::atomic<int> winner(-1);
+    std::vector<Minisat::lbool> results(workers_.size(), l_Undef);
+    for (auto& worker : workers_) {
+        worker->clearInterrupt();
+    }
+    std::vector<std::thread> threads;
+    for (int i = 0; i < workers_.size(); ++i) {
+        threads.emplace_back([&, i]() {
+            results[i] = workers_[i]->Run(assumps, finished, exchanges_);
+            int expected = -1;
+            if (results[i] != l_Undef && winner.compare_exchange_strong(expected, i)) {
+                finished.store(true);
+                for (int j = 0; j < workers_.size(); ++j) {
+                    if (j != i) workers_[j]->interrupt();
+                }
+            }
+        });
+    }
+    for (auto& t : threads) t.join();
+
+    int w = winner.load();
+    if (w < 0 || results[w] != l_True) {
+        return std::vector<bool>();
+    }
+    return ExtractMinisatModel(*workers_[w], sat_.NumVariables());
+}
+
+}
@@ -0,0 +1,57 @@
+#include "sat/profiled_constraint.h"
+
+#include <chrono>
+
+namespace Minisat {
+
+namespace {
+
+double SecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+}
+
+ConstraintProfile& ConstraintProfile::operator+=(const ConstraintProfile& other) {
+    propagate_calls += other.propagate_calls;
+    calc_reason_calls += other.calc_reason_calls;
+    undo_calls += other.undo_calls;
+    propagations += other.propagations;
+    conflicts += other.conflicts;
+    reason_literals += other.reason_literals;
+    propagate_seconds += other.propagate_seconds;
+    calc_reason_seconds += other.calc_reason_seconds;
+    return *this;
+}
+
+bool ProfiledConstraint::initialize(Solver& solver, vec<Lit>& out_watchers) {
+    return initializeImpl(solver, out_watchers);
+}
+bool ProfiledConstraint::propagate(Solver& solver, Lit p) {
+    // enqueue() puts the literals on the trail without propagating them, so the growth of the trail
+    // is exactly what this call derived
+    std::chrono::steady_clock::time_point start;
+    if (timed_) start = std::chrono::steady_clock::now();
+    int n_assigns = solver.nAssigns();
+    bool ok = propagateImpl(solver, p);
+    ++profile_.propagate_calls;
+    profile_.propagations += solver.nAssigns() - n_assigns;
+    if (!ok) ++profile_.conflicts;
+    if (timed_) profile_.propagate_seconds += SecondsSince(start);
+    return ok;
+}
+void ProfiledConstraint::calcReason(Solver& solver, Lit p, vec<Lit>& out_reason) {
+    std::chrono::steady_clock::time_point start;
+    if (timed_) start = std::chrono::steady_clock::now();
+    int size = out_reason.size();
+    calcReasonImpl(solver, p, out_reason);
+    ++profile_.calc_reason_calls;
+    profile_.reason_literals += out_reason.size() - size;
+    if (timed_) profile_.calc_reason_seconds += SecondsSince(start);
+}
+void ProfiledConstraint::undo(Solver& solver, Lit p) {
+    ++profile_.undo_calls;
+    undoImpl(solver, p);
+}
+
+}
@@ -1,6 +1,8 @@
 #include "sat/solver.h"
 
 #include <vector>
+#include <chrono>
+#include <thread>
 
 #include "minisat/core/Solver.h"
 
@@ -8,52 +10,184 @@
 
 namespace csugar { 
 
-std::vector<bool> Solver::Solve(bool incremental) {
-    // TODO: incremental solver
-    if (!actual_solver_ || !incremental) {
-        actual_solver_ = std::move(std::make_unique<Minisat::Solver>());
+void AddClauseToMinisat(Minisat::Solver& solver, const std::vector<SATLit>& clause) {
+    Minisat::vec<Minisat::Lit> c;
+    for (SATLit lit : clause) {
+        if (lit == SAT::True()) return;
+        if (lit != SAT::False()) {
+            c.push(Minisat::mkLit(lit.GetVariable(), lit.IsNegative()));
+        }
+    }
+    solver.addClause_(c);
+}
+std::vector<bool> ExtractMinisatModel(const Minisat::Solver& solver, int n_variables) {
+    std::vector<bool> ret(n_variables);
+    Minisat::lbool ltrue((uint8_t)0);
+    for (int i = 0; i < n_variables; ++i) {
+        ret[i] = (solver.model[i] == ltrue);
+    }
+    return ret;
+}
+
+void Solver::AddClause(const std::vector<SATLit>& clause) {
+    PrepareSolver();
+    AddClauseToMinisat(*actual_solver_, clause);
+    ++stats_.clauses;
+}
+void Solver::AddConstraint(std::shared_ptr<NonClauseConstraint> constraint) {
+    PrepareSolver();
+    AddConstraintToMinisat(*constraint);
+}
+void Solver::AddConstraintToMinisat(const NonClauseConstraint& constraint) {
+    std::unique_ptr<Minisat::Constraint> emitted = constraint.Emit();
+    auto profiled = dynamic_cast<Minisat::ProfiledConstraint*>(emitted.get());
+    if (profiled) profiled->setTimed(profile_timing_);
+    profiled_.push_back(profiled);
+    actual_solver_->addConstraint(std::move(emitted));
+    ++stats_.constraints;
+}
+void Solver::PrepareSolver() {
+    if (!actual_solver_) {
+        actual_solver_ = std::make_unique<Minisat::Solver>();
     }
-    for (int i = incremental ? sat_.NumSolvedVariables() : 0; i < sat_.NumVariables(); ++i) {
+    while (actual_solver_->nVars() < sat_.NumVariables()) {
         actual_solver_->newVar();
     }
+}
+bool Solver::LoadPending(bool incremental) {
+    if (!incremental) {
+        FoldProfiles();
+        actual_solver_.reset();
+    }
+    PrepareSolver();
     for (int i = incremental ? sat_.NumSolvedClauses() : 0; i < sat_.NumClauses(); ++i) {
-        const std::vector<SATLit>& clause = sat_.GetClause(i);
-        bool is_true = false;
-        for (SATLit lit : clause) {
-            if (lit == SAT::True()) is_true = true;
-        }
-        if (is_true) continue;
-        Minisat::vec<Minisat::Lit> c;
-        for (SATLit lit : clause) {
-            if (lit != SAT::False()) {
-                //printf("%d ", (lit.IsNegative() ? -1 : 1) * (lit.GetVariable() + 1));
-                c.push(Minisat::mkLit(lit.GetVariable(), lit.IsNegative()));
-            }
-        }
-        //printf("0\n");
-        actual_solver_->addClause_(c);
+        AddClause(sat_.GetClause(i));
     }
     for (int i = incremental ? sat_.NumSolverConstraints() : 0; i < sat_.NumConstraints(); ++i) {
-        actual_solver_->addConstraint(sat_.GetConstraint(i)->Emit());
+        AddConstraintToMinisat(*sat_.GetConstraint(i));
     }
     sat_.SetAllSolved();
 
-    if (!actual_solver_->simplify()) {
+    return actual_solver_->simplify();
+}
+std::vector<bool> Solver::Solve(bool incremental) {
+    conflict_.clear();
+    interrupted_ = false;
+    if (!LoadPending(incremental)) {
         return std::vector<bool>();
     }
 
-    bool is_sat = actual_solver_->solve();
-    if (!is_sat) {
+    Minisat::lbool status = SolveLimited(Minisat::vec<Minisat::Lit>());
+    if (status == l_Undef) {
+        interrupted_ = true;
+        return std::vector<bool>();
+    }
+    if (status != l_True) {
+        return std::vector<bool>();
+    }
+    return ExtractMinisatModel(*actual_solver_, sat_.NumVariables());
+}
+std::vector<bool> Solver::SolveUnder(const std::vector<SATLit>& assumptions) {
+    conflict_.clear();
+    interrupted_ = false;
+    if (!LoadPending(true)) {
         return std::vector<bool>();
     }
 
-    std::vector<bool> ret(sat_.NumVariables());
-    Minisat::lbool ltrue((uint8_t)0);
-    for (int i = 0; i < sat_.NumVariables(); ++i) {
-        ret[i] = (actual_solver_->model[i] == ltrue);
+    Minisat::vec<Minisat::Lit> assumps;
+    for (SATLit lit : assumptions) {
+        if (lit == SAT::True()) continue;
+        if (lit == SAT::False()) {
+            // variable 0 is not constrained in MiniSat, so this assumption must not be passed to it
+            conflict_.push_back(lit);
+            return std::vector<bool>();
+        }
+        assumps.push(Minisat::mkLit(lit.GetVariable(), lit.IsNegative()));
+    }
+    Minisat::lbool status = SolveLimited(assumps);
+    if (status == l_Undef) {
+        interrupted_ = true;
+        return std::vector<bool>();
+    }
+    if (status != l_True) {
+        // MiniSat reports the negations of the failed assumptions
+        for (int i = 0; i < actual_solver_->conflict.size(); ++i) {
+            Minisat::Lit lit = actual_solver_->conflict[i];
+            conflict_.push_back(SATLit(Minisat::var(lit), !Minisat::sign(lit)));
+        }
+        return std::vector<bool>();
+    }
+    return ExtractMinisatModel(*actual_solver_, sat_.NumVariables());
+}
+Minisat::lbool Solver::SolveLimited(const Minisat::vec<Minisat::Lit>& assumptions) {
+    actual_solver_->budgetOff();
+    if (conflict_budget_ >= 0) actual_solver_->setConfBudget(conflict_budget_);
+    if (propagation_budget_ >= 0) actual_solver_->setPropBudget(propagation_budget_);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_ = true;
+        if (interrupt_requested_) actual_solver_->interrupt();
+    }
+
+    std::thread watchdog;
+    if (time_limit_ >= 0) {
+        watchdog = std::thread([this]() {
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (!finished_.wait_for(lock, std::chrono::duration<double>(time_limit_), [this]() { return !running_; })) {
+                actual_solver_->interrupt();
+            }
+        });
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    uint64_t conflicts = actual_solver_->conflicts;
+    uint64_t decisions = actual_solver_->decisions;
+    uint64_t propagations = actual_solver_->propagations;
+    Minisat::lbool status = actual_solver_->solveLimited(assumptions);
+    stats_.conflicts += actual_solver_->conflicts - conflicts;
+    stats_.decisions += actual_solver_->decisions - decisions;
+    stats_.propagations += actual_solver_->propagations - propagations;
+    stats_.seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_ = false;
+        interrupt_requested_ = false;
     }
+    finished_.notify_all();
+    if (watchdog.joinable()) watchdog.join();
 
+    actual_solver_->clearInterrupt();
+    actual_solver_->budgetOff();
+    return status;
+}
+SolverStats Solver::Stats() const {
+    SolverStats ret = stats_;
+    for (int i = 0; i < profiled_.size(); ++i) {
+        if (ret.constraint_profiles.size() <= i) ret.constraint_profiles.emplace_back();
+        if (profiled_[i]) ret.constraint_profiles[i] += profiled_[i]->profile();
+    }
     return ret;
 }
+void Solver::SetProfileTiming(bool timed) {
+    profile_timing_ = timed;
+    for (auto profiled : profiled_) {
+        if (profiled) profiled->setTimed(timed);
+    }
+}
+void Solver::FoldProfiles() {
+    stats_ = Stats();
+    profiled_.clear();
+}
+void Solver::Interrupt() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    interrupt_requested_ = true;
+    if (running_) actual_solver_->interrupt();
+}
+SATLit Solver::NewVariable() {
+    int id = sat_.NumVariables();
+    sat_.AddVariables(1);
+    PrepareSolver();
+    return SATLit(id);
+}
 
 }
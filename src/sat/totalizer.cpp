@@ -0,0 +1,34 @@
+#include "sat/totalizer.h"
+
+namespace csugar {
+
+Totalizer::Totalizer(Solver& solver, const std::vector<SATLit>& inputs) {
+    outputs_ = Build(solver, inputs, 0, inputs.size());
+}
+std::vector<SATLit> Totalizer::Build(Solver& solver, const std::vector<SATLit>& inputs, int begin, int end) {
+    if (end - begin == 1) {
+        return {inputs[begin]};
+    }
+    int mid = (begin + end) / 2;
+    std::vector<SATLit> left = Build(solver, inputs, begin, mid);
+    std::vector<SATLit> right = Build(solver, inputs, mid, end);
+
+    std::vector<SATLit> ret;
+    for (int i = 0; i < end - begin; ++i) {
+        ret.push_back(solver.NewVariable());
+    }
+    // (left >= i) && (right >= j) -> (ret >= i + j)
+    for (int i = 0; i <= left.size(); ++i) {
+        for (int j = 0; j <= right.size(); ++j) {
+            if (i + j == 0) continue;
+            std::vector<SATLit> clause;
+            if (i > 0) clause.push_back(!left[i - 1]);
+            if (j > 0) clause.push_back(!right[j - 1]);
+            clause.push_back(ret[i + j - 1]);
+            solver.AddClause(clause);
+        }
+    }
+    return ret;
+}
+
+}
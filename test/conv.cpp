@@ -8,16 +8,26 @@
 #include "csp/var.h"
 #include "common/interval_domain.h"
 #include "icsp/icsp.h"
+#include "icsp/decomposition.h"
 #include "conv/converter.h"
+#include "conv/cost_model.h"
 
 using namespace csugar;
 
 void ConvertTest1();
 void ConvertTest2();
+void DecompositionTest();
+void DecompositionFixedVarTest();
+void OriginTest();
+void CostModelTest();
 
 void RunConvertTests() {
     ConvertTest1();
     ConvertTest2();
+    DecompositionTest();
+    DecompositionFixedVarTest();
+    OriginTest();
+    CostModelTest();
 }
 
 void ConvertTest1() {
@@ -54,3 +64,117 @@ void ConvertTest2() {
     assert(icsp.NumClauses() == 1);
     assert(icsp.GetClause(0).str() == "[i0*2+i1*-1+-1<=0]");
 }
+
+void DecompositionTest() {
+    // (a xor b) and (x + y <= 3) are unrelated; c occurs in no constraint
+    CSP csp;
+    auto a = csp.MakeBoolVar();
+    auto b = csp.MakeBoolVar();
+    auto c = csp.MakeBoolVar();
+    auto x = csp.MakeIntVar(std::make_unique<IntervalDomain>(0, 3));
+    auto y = csp.MakeIntVar(std::make_unique<IntervalDomain>(0, 3));
+    csp.AddExpr(Expr::Make(kXor, {Expr::VarBool(a), Expr::VarBool(b)}));
+    csp.AddExpr(Expr::Make(kLe, {Expr::Make(kAdd, {Expr::VarInt(x), Expr::VarInt(y)}), Expr::ConstInt(3)}));
+
+    ICSP icsp;
+    Converter conv(csp, icsp);
+    conv.Convert();
+
+    ICSPDecomposition decomposition = DecomposeICSP(icsp, std::vector<bool>(icsp.NumIntVars(), false));
+    assert(decomposition.n_components == 3);
+    int ab = decomposition.bool_component[conv.ConvertBoolVar(a)->id()];
+    int xy = decomposition.int_component[conv.ConvertIntVar(x)->id()];
+    assert(decomposition.bool_component[conv.ConvertBoolVar(b)->id()] == ab);
+    assert(decomposition.int_component[conv.ConvertIntVar(y)->id()] == xy);
+    assert(ab != xy);
+    int rest = decomposition.bool_component[conv.ConvertBoolVar(c)->id()];
+    assert(rest != ab && rest != xy);
+    for (int i = 0; i < icsp.NumClauses(); ++i) {
+        assert(decomposition.clause_component[i] == ab || decomposition.clause_component[i] == xy);
+    }
+}
+
+void DecompositionFixedVarTest() {
+    // (x + z <= 4) and (y + z <= 4) share only z, which has a single value
+    CSP csp;
+    auto x = csp.MakeIntVar(std::make_unique<IntervalDomain>(0, 3));
+    auto y = csp.MakeIntVar(std::make_unique<IntervalDomain>(0, 3));
+    auto z = csp.MakeIntVar(std::make_unique<IntervalDomain>(2, 2));
+    csp.AddExpr(Expr::Make(kLe, {Expr::Make(kAdd, {Expr::VarInt(x), Expr::VarInt(z)}), Expr::ConstInt(4)}));
+    csp.AddExpr(Expr::Make(kLe, {Expr::Make(kAdd, {Expr::VarInt(y), Expr::VarInt(z)}), Expr::ConstInt(4)}));
+
+    ICSP icsp;
+    Converter conv(csp, icsp);
+    conv.Convert();
+
+    std::vector<bool> fixed;
+    for (int i = 0; i < icsp.NumIntVars(); ++i) fixed.push_back(icsp.GetIntVar(i)->domain()->size() <= 1);
+    ICSPDecomposition decomposition = DecomposeICSP(icsp, fixed);
+    int cx = decomposition.int_component[conv.ConvertIntVar(x)->id()];
+    int cy = decomposition.int_component[conv.ConvertIntVar(y)->id()];
+    int cz = decomposition.int_component[conv.ConvertIntVar(z)->id()];
+    assert(decomposition.n_components == 3);
+    assert(cx != cy && cz != cx && cz != cy);
+}
+
+void OriginTest() {
+    // a; x0 + x1 + x2 + x3 + x4 <= 200, which is long enough for ReduceArity
+    CSP csp;
+    auto a = csp.MakeBoolVar();
+    std::vector<std::shared_ptr<Expr>> x;
+    for (int i = 0; i < 5; ++i) {
+        x.push_back(Expr::VarInt(csp.MakeIntVar(std::make_unique<IntervalDomain>(0, 100))));
+    }
+    csp.AddExpr(Expr::VarBool(a));
+    csp.AddExpr(Expr::Make(kLe, {Expr::Make(kAdd, {x[0], x[1], x[2], x[3], x[4]}), Expr::ConstInt(200)}));
+
+    ICSP icsp;
+    Converter conv(csp, icsp);
+    conv.Convert();
+
+    // clauses defining auxiliary variables belong to the constraint which introduced them
+    assert(icsp.NumClauses() >= 2);
+    assert(icsp.GetClause(0).origin() == 0);
+    for (int i = 1; i < icsp.NumClauses(); ++i) {
+        assert(icsp.GetClause(i).origin() == 1);
+    }
+
+    auto& notes = conv.Notes();
+    assert(notes.size() == 2);
+    assert(notes[0].aux_int_vars.empty() && notes[0].split_thresholds.empty());
+    assert(notes[1].split_thresholds.size() == 1);
+}
+
+void CostModelTest() {
+    // x0 + x1 + x2 + x3 + x4 <= 6, which is small enough to be encoded directly by default
+    auto convert = [](const Config& config, std::vector<int>& split_thresholds) {
+        CSP csp;
+        std::vector<std::shared_ptr<Expr>> x;
+        for (int i = 0; i < 5; ++i) {
+            x.push_back(Expr::VarInt(csp.MakeIntVar(std::make_unique<IntervalDomain>(0, 3))));
+        }
+        csp.AddExpr(Expr::Make(kLe, {Expr::Make(kAdd, {x[0], x[1], x[2], x[3], x[4]}), Expr::ConstInt(6)}));
+
+        ICSP icsp;
+        Converter conv(csp, icsp);
+        conv.SetCofig(config);
+        conv.Convert();
+        split_thresholds = conv.Notes()[0].split_thresholds;
+        return conv.IsOverBudget();
+    };
+    std::vector<int> split_thresholds;
+
+    // the cost model is opt-in: by default, the split depends on the domain size only
+    Config config;
+    assert(!config.use_cost_model);
+    assert(!convert(config, split_thresholds));
+    assert(split_thresholds.size() == 1 && split_thresholds[0] == EncodingChoice::kDirect);
+
+    config.use_cost_model = true;
+    config.max_literal_clauses = 16;
+    assert(!convert(config, split_thresholds));
+    assert(split_thresholds.size() == 1 && split_thresholds[0] != EncodingChoice::kDirect);
+
+    config.clause_budget = 10;
+    assert(convert(config, split_thresholds));
+}
@@ -1,8 +1,10 @@
 #include "tests.h"
 
+#include <algorithm>
 #include <cassert>
 #include <memory>
 #include <map>
+#include <set>
 #include <vector>
 
 #include "csp/csp.h"
@@ -16,14 +18,418 @@
 #include "sat/sat.h"
 #include "sat/mapping.h"
 #include "sat/solver.h"
+#include "integrated/integrated.h"
 
 using namespace csugar;
 
 namespace {
 void RunIntegratedSolvingTest1();
+void ClauseBudgetTest();
+void UniquenessTest();
+void PushPopTest();
+void InterruptTest();
+void EnumerateTest();
+void MinimizeCluesTest();
+void SolveMaximalTest();
+void OptimizeTest();
+void MaxSATTest();
+void EnumerateParallelTest();
+void CountSolutionsTest();
+void ComponentsTest();
 }
 void RunIntegratedSolvingTests() {
-    puts("integrated test is temporarily disabled");
+    ClauseBudgetTest();
+    UniquenessTest();
+    PushPopTest();
+    InterruptTest();
+    EnumerateTest();
+    MinimizeCluesTest();
+    SolveMaximalTest();
+    OptimizeTest();
+    MaxSATTest();
+    EnumerateParallelTest();
+    CountSolutionsTest();
+    ComponentsTest();
+}
+
+namespace {
+void ClauseBudgetTest() {
+    auto make_solver = [](IntegratedCSPSolver& solver) {
+        for (auto v : {"a", "b", "c", "d", "e"}) {
+            solver.Parse(std::string("(int ") + v + " 0 3)");
+        }
+        solver.Parse("(<= (+ a b c d e) 6)");
+    };
+    {
+        IntegratedCSPSolver solver;
+        make_solver(solver);
+        assert(solver.Solve().IsSat());
+        assert(!solver.IsOverBudget());
+        assert(!solver.GetStats().over_budget);
+    }
+    {
+        IntegratedCSPSolver solver;
+        solver.SetClauseBudget(10);
+        make_solver(solver);
+        CSPAnswer answer = solver.Solve();
+        assert(answer.IsSat());
+        assert(solver.IsOverBudget());
+        assert(answer.Stats().over_budget && answer.Stats().estimated_clauses > 10);
+    }
+}
+void UniquenessTest() {
+    IntegratedCSPSolver solver;
+    solver.Parse("(int x 1 3)");
+    solver.Parse("(int y 1 3)");
+    solver.Parse("(< x y)");
+
+    assert(solver.CheckUniqueness({}).status == UniquenessResult::kMultiple);
+    assert(solver.CheckUniqueness({{"x", 1}}).status == UniquenessResult::kMultiple);
+    UniquenessResult unique = solver.CheckUniqueness({{"x", 2}});
+    assert(unique.status == UniquenessResult::kUnique && unique.first.GetInt("y") == 3);
+    // clues outside the domains
+    assert(solver.CheckUniqueness({{"x", 5}}).status == UniquenessResult::kUnsat);
+    assert(solver.CheckUniqueness({{"y", 0}}).status == UniquenessResult::kUnsat);
+    assert(solver.CheckUniqueness({{"x", 3}}).status == UniquenessResult::kUnsat);
+
+    // repeated queries reuse the same auxiliary variables and clauses
+    CSPStats before = solver.GetStats();
+    assert(solver.CheckUniqueness({{"y", 2}}).status == UniquenessResult::kUnique);
+    CSPStats after = solver.GetStats();
+    assert(before.sat_vars == after.sat_vars && before.sat_clauses == after.sat_clauses);
+}
+void PushPopTest() {
+    {
+        IntegratedCSPSolver solver;
+        solver.Parse("(int x 1 3)");
+        solver.Parse("(int y 1 3)");
+        solver.Parse("(< x y)");
+
+        solver.Push();
+        solver.Parse("(>= x 2)");
+        CSPAnswer answer = solver.Solve();
+        assert(answer.IsSat() && answer.GetInt("x") == 2 && answer.GetInt("y") == 3);
+        solver.Parse("(< y 3)");
+        assert(!solver.Solve().IsSat());
+        solver.Pop();
+        assert(solver.NumScopes() == 0);
+
+        // (>= x 2) and (< y 3) are retracted
+        solver.Parse("(< x 2)");
+        answer = solver.Solve();
+        assert(answer.IsSat() && answer.GetInt("x") == 1);
+        solver.Parse("(< y 3)");
+        answer = solver.Solve();
+        assert(answer.IsSat() && answer.GetInt("y") == 2);
+    }
+    {
+        // unsatisfiable before the scope is opened
+        IntegratedCSPSolver solver;
+        solver.Parse("(int x 1 3)");
+        solver.Parse("(> x 5)");
+        solver.Push();
+        assert(solver.NumScopes() == 1);
+        solver.Parse("(>= x 2)");
+        assert(!solver.Solve().IsSat());
+        solver.Pop();
+        assert(solver.NumScopes() == 0);
+        assert(!solver.Solve().IsSat());
+    }
+    {
+        // misuse is reported, not aborted on
+        IntegratedCSPSolver solver;
+        solver.Parse("(bool a)");
+        solver.Parse("(bool b)");
+        assert(!solver.Pop());
+        solver.Push();
+        bool refused = false;
+        try {
+            solver.Parse("(graph-active-vertices-connected 2 1 a b 0 1)");
+        } catch (const ParseError&) {
+            refused = true;
+        }
+        assert(refused);
+        assert(solver.Pop() && !solver.Pop());
+        solver.Parse("(graph-active-vertices-connected 2 1 a b 0 1)");
+    }
+}
+void InterruptTest() {
+    IntegratedCSPSolver solver;
+    solver.Parse("(int x 0 5)");
+    solver.Parse("(int y 0 5)");
+    solver.Parse("(>= (+ x y) 4)");
+    auto objective = StringToExpr("(+ x y)", {}, {{"x", solver.GetIntVar("x")}, {"y", solver.GetIntVar("y")}});
+
+    // an interrupted search proves nothing, so no bound may be learnt from it
+    solver.Interrupt();
+    CSPAnswer answer = solver.Minimize(objective);
+    assert(answer.IsUnknown() && !answer.IsSat());
+    assert(solver.Interrupted());
+    answer = solver.Minimize(objective);
+    assert(!solver.Interrupted());
+    assert(answer.IsSat() && answer.GetObjective() == 4);
+    answer = solver.Maximize(objective);
+    assert(answer.IsSat() && answer.GetObjective() == 10);
+
+    // an interrupt issued from the callback stops the enumeration, which leaves no blocking clause behind
+    int n = solver.Enumerate([&](const CSPAnswer&) {
+        solver.Interrupt();
+        return true;
+    });
+    assert(n == 1 && solver.Interrupted());
+    CountResult count = solver.CountSolutions();
+    assert(count.count == 26 && !solver.Interrupted());
+}
+void EnumerateTest() {
+    // (1, 2), (1, 3), (2, 3)
+    IntegratedCSPSolver solver;
+    solver.Parse("(int x 1 3)");
+    solver.Parse("(int y 1 3)");
+    solver.Parse("(< x y)");
+
+    std::set<std::pair<int, int>> solutions;
+    int n = solver.Enumerate([&](const CSPAnswer& answer) {
+        solutions.insert({answer.GetInt("x"), answer.GetInt("y")});
+        return true;
+    });
+    assert(n == 3 && solutions == (std::set<std::pair<int, int>>{{1, 2}, {1, 3}, {2, 3}}));
+
+    // stopped by the limit and by the callback
+    assert(solver.Enumerate([](const CSPAnswer&) { return true; }, 2) == 2);
+    assert(solver.Enumerate([](const CSPAnswer&) { return false; }) == 1);
+
+    // solutions differing only on y are not distinguished
+    solver.SetTargetVars({"x"});
+    std::set<int> xs;
+    n = solver.Enumerate([&](const CSPAnswer& answer) {
+        assert(!answer.Has("y"));
+        xs.insert(answer.GetInt("x"));
+        return true;
+    });
+    assert(n == 2 && xs == (std::set<int>{1, 2}));
+}
+void MinimizeCluesTest() {
+    // a permutation of 1..3 is determined by any two of its values, but not by one
+    IntegratedCSPSolver solver;
+    solver.Parse("(int a 1 3)");
+    solver.Parse("(int b 1 3)");
+    solver.Parse("(int c 1 3)");
+    solver.Parse("(alldifferent a b c)");
+
+    std::vector<std::pair<std::string, int>> clues{{"a", 1}, {"b", 2}, {"c", 3}};
+    auto minimized = solver.MinimizeClues(clues);
+    assert(minimized.has_value() && minimized->size() == 2);
+    assert(solver.CheckUniqueness(*minimized).status == UniquenessResult::kUnique);
+    for (int i = 0; i < 2; ++i) {
+        auto rest = *minimized;
+        rest.erase(rest.begin() + i);
+        assert(solver.CheckUniqueness(rest).status == UniquenessResult::kMultiple);
+    }
+
+    // clues which do not determine the solution, or contradict each other
+    assert(!solver.MinimizeClues({{"a", 1}}).has_value());
+    assert(!solver.MinimizeClues({{"a", 1}, {"b", 1}}).has_value());
+
+    // the clues do not persist
+    assert(solver.CheckUniqueness({}).status == UniquenessResult::kMultiple);
+}
+void SolveMaximalTest() {
+    // the maximal true sets are {p, r} and {q, r}
+    IntegratedCSPSolver solver;
+    solver.Parse("(bool p)");
+    solver.Parse("(bool q)");
+    solver.Parse("(bool r)");
+    solver.Parse("(not (and p q))");
+
+    CSPAnswer answer = solver.SolveMaximal();
+    assert(answer.IsSat());
+    assert(answer.GetBool("r") && answer.GetBool("p") != answer.GetBool("q"));
+
+    // now only singletons are maximal
+    solver.Parse("(or (not p) (not r))");
+    solver.Parse("(or (not q) (not r))");
+    answer = solver.SolveMaximal();
+    assert(answer.IsSat());
+    assert((int)answer.GetBool("p") + (int)answer.GetBool("q") + (int)answer.GetBool("r") == 1);
+
+    solver.Parse("(or p q)");
+    solver.Parse("(not p)");
+    solver.Parse("(not q)");
+    assert(!solver.SolveMaximal().IsSat());
+}
+void OptimizeTest() {
+    for (auto search : {ObjectiveSearch::kLinear, ObjectiveSearch::kBinary, ObjectiveSearch::kLowerBound}) {
+        IntegratedCSPSolver solver;
+        solver.SetObjectiveSearch(search);
+        solver.Parse("(int x 0 9)");
+        solver.Parse("(int y 0 9)");
+        solver.Parse("(>= (+ x y y) 7)");
+        solver.Parse("(< x (+ y 4))");
+        std::map<std::string, CSPIntVar> int_map{{"x", solver.GetIntVar("x")}, {"y", solver.GetIntVar("y")}};
+
+        // x + y is at least 4, at (1, 3) and (0, 4); x - y is at most 3, at (x, x - 3) with x >= 5
+        CSPAnswer answer = solver.Minimize(StringToExpr("(+ x y)", {}, int_map));
+        assert(answer.IsSat() && answer.GetObjective() == 4);
+        assert(answer.GetInt("x") + answer.GetInt("y") == 4);
+        answer = solver.Maximize(StringToExpr("(- x y)", {}, int_map));
+        assert(answer.IsSat() && answer.GetObjective() == 3);
+        assert(answer.GetInt("x") - answer.GetInt("y") == 3);
+
+        // bounds learnt by the previous queries must not restrict this one
+        answer = solver.Maximize(StringToExpr("(+ x y)", {}, int_map));
+        assert(answer.IsSat() && answer.GetObjective() == 18);
+
+        solver.Parse("(minimize (- y x))");
+        assert(solver.HasObjective());
+        answer = solver.Optimize();
+        assert(answer.IsSat() && answer.GetObjective() == -3);
+
+        solver.Parse("(> y 9)");
+        assert(!solver.Optimize().IsSat());
+    }
+}
+void MaxSATTest() {
+    {
+        // violating a (3) is cheaper than violating both b and c (4)
+        IntegratedCSPSolver solver;
+        solver.Parse("(bool a)");
+        solver.Parse("(bool b)");
+        solver.Parse("(bool c)");
+        solver.Parse("(not (and a b))");
+        solver.Parse("(not (and a c))");
+        solver.Parse("(soft 3 a)");
+        solver.Parse("(soft 2 b)");
+        solver.Parse("(soft 2 c)");
+        assert(solver.HasSoftConstraints());
+
+        CSPAnswer answer = solver.SolveMaxSAT();
+        assert(answer.IsSat() && answer.GetObjective() == 3);
+        assert(!answer.GetBool("a") && answer.GetBool("b") && answer.GetBool("c"));
+    }
+    {
+        // at most one of the four unit-weight soft constraints can hold, which needs a totalizer;
+        // the weighted one on n is kept
+        IntegratedCSPSolver solver;
+        solver.Parse("(int n 0 5)");
+        for (auto v : {"x1", "x2", "x3", "x4"}) {
+            solver.Parse(std::string("(bool ") + v + ")");
+            solver.Parse(std::string("(soft 1 ") + v + ")");
+        }
+        solver.Parse("(<= (+ (if x1 1 0) (if x2 1 0) (if x3 1 0) (if x4 1 0)) 1)");
+        solver.Parse("(soft 5 (>= n 3))");
+        solver.Parse("(soft 2 (< n 4))");
+
+        CSPAnswer answer = solver.SolveMaxSAT();
+        assert(answer.IsSat() && answer.GetObjective() == 3);
+        assert(answer.GetInt("n") == 3);
+
+        solver.Parse("(> n 3)");
+        answer = solver.SolveMaxSAT();
+        assert(answer.IsSat() && answer.GetObjective() == 5);
+
+        solver.Parse("(< n 2)");
+        assert(!solver.SolveMaxSAT().IsSat());
+    }
+    {
+        // weights and the total beyond the range of int
+        IntegratedCSPSolver solver;
+        solver.Parse("(bool a)");
+        solver.Parse("(bool b)");
+        solver.Parse("(not (and a b))");
+        solver.Parse("(soft 3000000000 a)");
+        solver.Parse("(soft 4000000000 b)");
+        solver.Parse("(soft 5000000000 (not b))");
+        CSPAnswer answer = solver.SolveMaxSAT();
+        assert(answer.IsSat() && answer.GetObjective() == 4000000000LL);
+        assert(answer.GetBool("a") && !answer.GetBool("b"));
+
+        for (auto in : {"(soft a)", "(soft x a)", "(soft 0 a)", "(soft -1 a)", "(soft 99999999999999999999 a)"}) {
+            bool refused = false;
+            try {
+                solver.Parse(in);
+            } catch (const ParseError&) {
+                refused = true;
+            }
+            assert(refused);
+        }
+    }
+}
+void EnumerateParallelTest() {
+    // 12 pairs (x, y) with x + y <= 4 and x != y, each found exactly once, in the same order on every run
+    auto enumerate = [](int max_solutions) {
+        IntegratedCSPSolver solver;
+        solver.SetStoreSATClauses(true);
+        solver.Parse("(int x 0 5)");
+        solver.Parse("(int y 0 5)");
+        solver.Parse("(<= (+ x y) 4)");
+        solver.Parse("(!= x y)");
+        std::vector<std::pair<int, int>> solutions;
+        solver.EnumerateParallel([&](const CSPAnswer& answer) {
+            solutions.push_back({answer.GetInt("x"), answer.GetInt("y")});
+            return true;
+        }, max_solutions, 4);
+        return solutions;
+    };
+    std::vector<std::pair<int, int>> solutions = enumerate(-1);
+    std::set<std::pair<int, int>> distinct(solutions.begin(), solutions.end());
+    assert(solutions.size() == 12 && distinct.size() == 12);
+    for (auto [x, y] : solutions) assert(x + y <= 4 && x != y);
+    assert(enumerate(-1) == solutions);
+
+    std::vector<std::pair<int, int>> first = enumerate(5);
+    assert(first.size() == 5 && std::equal(first.begin(), first.end(), solutions.begin()));
+}
+void CountSolutionsTest() {
+    // 12 pairs (x, y) with x + y <= 4 and x != y; x takes the values 0..4
+    for (int enumeration_limit : {64, 4}) {
+        IntegratedCSPSolver solver;
+        solver.SetStoreSATClauses(true);
+        solver.Parse("(int x 0 5)");
+        solver.Parse("(int y 0 5)");
+        solver.Parse("(<= (+ x y) 4)");
+        solver.Parse("(!= x y)");
+
+        CountResult result = solver.CountSolutions(enumeration_limit);
+        assert(result.count == 12 && result.by_enumeration == (enumeration_limit == 64));
+        solver.SetTargetVars({"x"});
+        result = solver.CountSolutions(enumeration_limit);
+        assert(result.count == 5 && result.by_enumeration == (enumeration_limit == 64));
+
+        solver.Parse("(> x 4)");
+        assert(solver.CountSolutions(enumeration_limit).count == 0);
+    }
+    {
+        // without the stored clauses the enumeration goes on to the end
+        IntegratedCSPSolver solver;
+        solver.Parse("(int x 0 5)");
+        solver.Parse("(int y 0 5)");
+        solver.Parse("(<= (+ x y) 4)");
+        solver.Parse("(!= x y)");
+        CountResult result = solver.CountSolutions(4);
+        assert(result.count == 12 && result.by_enumeration);
+        assert(solver.CountSolutions(4).count == 12);
+    }
+}
+void ComponentsTest() {
+    // (x + z <= 4) and (y + z <= 4) share z, which is narrowed to one value after it has been encoded
+    IntegratedCSPSolver solver;
+    solver.SetSolveMode(SolveMode::kComponents, 2);
+    solver.Parse("(int x 0 3)");
+    solver.Parse("(int y 0 3)");
+    solver.Parse("(int z 0 3)");
+    solver.Parse("(<= (+ x z) 4)");
+    solver.Parse("(<= (+ y z) 4)");
+    CSPAnswer answer = solver.Solve();
+    assert(answer.IsSat());
+    assert(solver.Solve().IsSat());
+
+    solver.Parse("(>= z 3)");
+    answer = solver.Solve();
+    assert(answer.IsSat() && answer.GetInt("z") == 3);
+    assert(answer.GetInt("x") <= 1 && answer.GetInt("y") <= 1);
+    solver.Parse("(>= y 2)");
+    assert(!solver.Solve().IsSat());
+}
 }
 
 /*
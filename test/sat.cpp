@@ -0,0 +1,274 @@
+#include "tests.h"
+
+#include <algorithm>
+#include <cassert>
+#include <memory>
+#include <sstream>
+#include <vector>
+
+#include "sat/sat.h"
+#include "sat/satlit.h"
+#include "sat/dimacs.h"
+#include "sat/solver.h"
+#include "sat/backbone.h"
+#include "sat/totalizer.h"
+#include "sat/cube.h"
+#include "sat/counter.h"
+#include "sat/constraints.h"
+#include "sat/graph_solver.h"
+#include "trace_solver.h"
+
+using namespace csugar;
+
+void DIMACSRoundTripTest();
+void BackboneTest();
+void TotalizerTest();
+void CubeSplitTest();
+void ProjectedCounterTest();
+void SolverInterruptTest();
+void ActiveVerticesConnectedTraceTest();
+
+void RunSATTests() {
+    DIMACSRoundTripTest();
+    BackboneTest();
+    TotalizerTest();
+    CubeSplitTest();
+    ProjectedCounterTest();
+    SolverInterruptTest();
+    ActiveVerticesConnectedTraceTest();
+}
+
+void DIMACSRoundTripTest() {
+    SAT sat;
+    sat.AddVariables(3);
+    sat.AddClause({SATLit(1), SATLit(2, true)});
+    sat.AddClause({SATLit(3, true)});
+    sat.AddClause({SATLit(1, true), SATLit(2), SATLit(3)});
+
+    std::stringstream cnf;
+    WriteDIMACS(sat, cnf);
+    assert(cnf.str() == "p cnf 4 4\n1 0\n2 -3 0\n-4 0\n-2 3 4 0\n");
+
+    SAT sat2;
+    assert(ReadDIMACS(cnf, sat2));
+    assert(sat2.NumVariables() == sat.NumVariables());
+    assert(sat2.NumClauses() == sat.NumClauses());
+    for (int i = 0; i < sat.NumClauses(); ++i) {
+        auto c1 = sat.GetClause(i), c2 = sat2.GetClause(i);
+        assert(c1.size() == c2.size());
+        for (int j = 0; j < c1.size(); ++j) {
+            assert(c1[j] == c2[j]);
+        }
+    }
+
+    MappingLayout layout;
+    layout.AddBool("x", 1);
+    layout.AddInt("y", {1, 3, 5}, 2);
+    std::stringstream layout_str;
+    layout.Write(layout_str);
+    assert(layout_str.str() == "b x 2\ni y 3 3 1 3 5\n");
+
+    MappingLayout layout2;
+    assert(layout2.Read(layout_str));
+    std::istringstream model("s SATISFIABLE\nv 1 2 -3 4 0\n");
+    std::vector<bool> assignment = ReadDIMACSModel(model, 4);
+    assert(layout2.RetrieveBool("x", assignment) == true);
+    assert(layout2.RetrieveInt("y", assignment) == 3);
+}
+
+void BackboneTest() {
+    SAT sat;
+    sat.AddVariables(4);
+    sat.AddClause({SATLit(1)});
+    sat.AddClause({SATLit(1, true), SATLit(2, true)});
+    sat.AddClause({SATLit(3), SATLit(4)});
+    sat.AddClause({SATLit(3, true), SATLit(4, true)});
+
+    Solver solver(sat);
+    std::vector<bool> model = solver.Solve();
+    assert(model.size() == 5);
+
+    std::vector<SATLit> candidates;
+    for (int i = 1; i <= 4; ++i) {
+        candidates.push_back(SATLit(i, !model[i]));
+    }
+    candidates.push_back(SAT::True());
+    std::vector<bool> backbone = ComputeBackbone(solver, candidates, model);
+    assert(backbone[0] == true);
+    assert(backbone[1] == true);
+    assert(backbone[2] == false);
+    assert(backbone[3] == false);
+    assert(backbone[4] == true);
+
+    // backbone literals are kept as clauses, so solving again keeps them
+    model = solver.SolveUnder({SATLit(3)});
+    assert(model.size() >= 5 && model[1] && !model[2] && !model[4]);
+    assert(solver.SolveUnder({SATLit(2)}).empty());
+    assert(solver.Conflict().size() == 1 && solver.Conflict()[0] == SATLit(2));
+}
+
+void TotalizerTest() {
+    SAT sat;
+    sat.AddVariables(4);
+    Solver solver(sat);
+    std::vector<SATLit> inputs;
+    for (int i = 1; i <= 4; ++i) inputs.push_back(SATLit(i));
+    Totalizer totalizer(solver, inputs);
+    assert(totalizer.size() == 4);
+
+    assert(!solver.SolveUnder({SATLit(1), SATLit(3), !totalizer.AtLeast(3)}).empty());
+    assert(solver.SolveUnder({SATLit(1), SATLit(3), SATLit(4), !totalizer.AtLeast(3)}).empty());
+    assert(solver.SolveUnder({SATLit(2), !totalizer.AtLeast(1)}).empty());
+}
+
+void CubeSplitTest() {
+    // exactly one of x1..x4 is true, and x5 <-> x1
+    SAT sat;
+    sat.AddVariables(5);
+    sat.AddClause({SATLit(1), SATLit(2), SATLit(3), SATLit(4)});
+    for (int i = 1; i <= 4; ++i) {
+        for (int j = i + 1; j <= 4; ++j) {
+            sat.AddClause({SATLit(i, true), SATLit(j, true)});
+        }
+    }
+    sat.AddClause({SATLit(5, true), SATLit(1)});
+    sat.AddClause({SATLit(5), SATLit(1, true)});
+
+    auto cubes = SplitIntoCubes(sat, {1, 2, 3, 4}, {}, 8);
+    assert(cubes.size() >= 2 && cubes.size() <= 8);
+
+    // each of the 4 solutions is covered by exactly one cube
+    for (int t = 1; t <= 4; ++t) {
+        std::vector<bool> model(6, false);
+        model[0] = true;
+        model[t] = true;
+        model[5] = (t == 1);
+        int n_covering = 0;
+        for (auto& cube : cubes) {
+            bool covers = true;
+            for (SATLit lit : cube) {
+                if (model[lit.GetVariable()] == lit.IsNegative()) covers = false;
+            }
+            if (covers) ++n_covering;
+        }
+        assert(n_covering == 1);
+    }
+
+    // x1 && x2 is refuted by propagation
+    assert(SplitIntoCubes(sat, {}, {SATLit(1), SATLit(2)}, 8).empty());
+}
+
+void ProjectedCounterTest() {
+    // (x1 || x2) and (x3 || x4) are independent components; x5 <-> (x1 && x3) is outside the projection
+    SAT sat;
+    sat.AddVariables(6);
+    sat.AddClause({SATLit(1), SATLit(2)});
+    sat.AddClause({SATLit(3), SATLit(4)});
+    sat.AddClause({SATLit(5, true), SATLit(1)});
+    sat.AddClause({SATLit(5, true), SATLit(3)});
+    sat.AddClause({SATLit(5), SATLit(1, true), SATLit(3, true)});
+
+    ProjectedCounter counter(sat, {1, 2, 3, 4, 6});
+    assert(counter.Count() == 3 * 3 * 2);
+    assert(counter.Count({SATLit(1, true)}) == 1 * 3 * 2);
+    assert(counter.Count({SATLit(1, true), SATLit(2, true)}) == 0);
+
+    // projecting away x2 and x4 merges the solutions differing only on them
+    ProjectedCounter projected(sat, {1, 3});
+    assert(projected.Count() == 4);
+
+    // non-clause constraints are refused
+    sat.AddConstraint(std::make_shared<ActiveVerticesConnectedConstraint>(std::vector<SATLit>{SATLit(1), SATLit(3)},
+                                                                          std::vector<std::pair<int, int>>{{0, 1}}));
+    ProjectedCounter unsupported(sat, {1, 3});
+    assert(!unsupported.IsSupported() && !unsupported.Count().has_value());
+}
+
+void SolverInterruptTest() {
+    SAT sat;
+    sat.AddVariables(2);
+    sat.AddClause({SATLit(1), SATLit(2)});
+    Solver solver(sat);
+
+    // an interrupt issued while no search is running stops the next one
+    solver.Interrupt();
+    assert(solver.SolveUnder({}).empty());
+    assert(solver.Interrupted());
+
+    // the solver stays usable afterwards
+    solver.SetBudget(1000, -1, 10.0);
+    std::vector<bool> model = solver.SolveUnder({SATLit(1, true)});
+    assert(!solver.Interrupted());
+    assert(model.size() == 3 && model[2]);
+    assert(solver.SolveUnder({SATLit(1, true), SATLit(2, true)}).empty());
+    assert(!solver.Interrupted());
+}
+
+void ActiveVerticesConnectedTraceTest() {
+    // Random assignments and undos on small grids: the incremental propagation must enqueue the same literals
+    // with the same reasons as a copy of the constraint which reanalyzes the whole grid every time
+    using Minisat::Lit;
+    uint32_t seed = 1;
+    auto random = [&](int n) {
+        seed = seed * 1103515245u + 12345u;
+        return (int)((seed >> 16) % n);
+    };
+    auto reason = [](Minisat::ActiveVerticesConnected& constraint, TraceSolver& solver, Lit p) {
+        Minisat::vec<Lit> out;
+        constraint.calcReason(solver, p, out);
+        std::vector<int> ret;
+        for (int i = 0; i < out.size(); ++i) ret.push_back(Minisat::toInt(out[i]));
+        return ret;
+    };
+
+    for (int side = 2; side <= 6; ++side) {
+        std::vector<std::pair<int, int>> edges = GridEdges(side);
+        for (int round = 0; round < 20; ++round) {
+            TraceSolver solvers[2];
+            std::vector<std::unique_ptr<Minisat::ActiveVerticesConnected>> constraints;
+            for (int k = 0; k < 2; ++k) {
+                std::vector<Lit> lits;
+                for (int i = 0; i < side * side; ++i) lits.push_back(Minisat::mkLit(solvers[k].newVar()));
+                constraints.push_back(std::make_unique<Minisat::ActiveVerticesConnected>(lits, edges));
+                constraints[k]->setIncremental(k == 0);
+                Minisat::vec<Lit> watchers;
+                assert(constraints[k]->initialize(solvers[k], watchers));
+            }
+            auto backtrack = [&](int level, int& qhead) {
+                for (auto& solver : solvers) solver.Backtrack(level);
+                qhead = std::min(qhead, solvers[0].TrailSize());
+            };
+
+            int qhead = 0;
+            for (int step = 0; step < 300; ++step) {
+                if (random(8) == 0) {
+                    backtrack(random(solvers[0].Level() + 1), qhead);
+                    continue;
+                }
+                Lit p = Minisat::mkLit(random(side * side), random(3) != 0);
+                if (solvers[0].value(p) != l_Undef) continue;
+                for (auto& solver : solvers) solver.Decide(p);
+
+                bool conflict = false;
+                while (!conflict && qhead < solvers[0].TrailSize()) {
+                    int implied_begin = solvers[0].TrailSize();
+                    Lit q = solvers[0].TrailAt(qhead++);
+                    bool ok = constraints[0]->propagate(solvers[0], q);
+                    assert(constraints[1]->propagate(solvers[1], q) == ok);
+                    assert(solvers[0].TrailSize() == solvers[1].TrailSize());
+                    for (int i = implied_begin; i < solvers[0].TrailSize(); ++i) {
+                        Lit r = solvers[0].TrailAt(i);
+                        assert(solvers[1].TrailAt(i) == r);
+                        if (ok) assert(reason(*constraints[0], solvers[0], r) == reason(*constraints[1], solvers[1], r));
+                    }
+                    if (!ok) {
+                        assert(reason(*constraints[0], solvers[0], Minisat::lit_Undef) == reason(*constraints[1], solvers[1], Minisat::lit_Undef));
+                        conflict = true;
+                    }
+                }
+                if (conflict) backtrack(solvers[0].Level() - 1, qhead);
+            }
+            backtrack(0, qhead);
+        }
+    }
+}
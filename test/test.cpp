@@ -6,5 +6,6 @@ int main()
 {
 	RunConvertTests();
 	RunIntegratedSolvingTests();
+	RunSATTests();
 	return 0;
 }
@@ -2,3 +2,4 @@
 
 void RunConvertTests();
 void RunIntegratedSolvingTests();
+void RunSATTests();